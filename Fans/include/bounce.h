@@ -9,6 +9,7 @@
 //      Bouncing Ball effect on an LED strip
 //
 // History:     Oct-04-2020     davepl      Created
+//              Oct-19-2026     davepl      Balls are now particles in a ParticleSystem
 //
 //---------------------------------------------------------------------------
 
@@ -16,10 +17,9 @@
 #define FASTLED_INTERNAL
 #include <FastLED.h>
 
-using namespace std;
-#include <vector>
-
 #include "ledgfx.h"
+#include "framecontext.h"
+#include "particles.h"
 
 static const CRGB ballColors [] =
 {
@@ -49,8 +49,12 @@ class BouncingBallEffect
     const double ImpactVelocity = InitialBallSpeed(StartHeight);
     const double SpeedKnob = 4.0;                   // Higher values will slow the effect
 
-    vector<double> ClockTimeAtLastBounce, Height, BallSpeed, Dampening;
-    vector<CRGB>   Colors;
+    // The balls are particles; heights of 0..StartHeight map onto the length of the strip and
+    // the SpeedKnob slows the clock, so both gravity and launch speed get scaled to pixel units
+
+    ParticleSystem    _balls;
+    GravityIntegrator _gravity;
+    BounceIntegrator  _bounce;
 
   public:
 
@@ -60,23 +64,24 @@ class BouncingBallEffect
     // balls should be drawn mirrored from each side.
 
     BouncingBallEffect(size_t cLength, size_t ballCount = 3, byte fade = 0, bool bMirrored = false)
-        : _cLength(cLength - 1),
+        : _cLength(cLength),
           _cBalls(ballCount),
           _fadeRate(fade),
           _bMirrored(bMirrored),
-          ClockTimeAtLastBounce(ballCount),
-          Height(ballCount),
-          BallSpeed(ballCount),
-          Dampening(ballCount),
-          Colors(ballCount)
+          _balls(ballCount, cLength),
+          _gravity(Gravity * (cLength - 1) / StartHeight / (SpeedKnob * SpeedKnob)),
+          _bounce(true, ImpactVelocity * (cLength - 1) / StartHeight / SpeedKnob, 0.01 * (cLength - 1) / SpeedKnob)
     {
+        _balls.AddIntegrator(&_gravity);
+        _balls.AddIntegrator(&_bounce);
+
         for (size_t i = 0; i < ballCount; i++)
         {
-            Height[i]                = StartHeight;                 // Current Ball Height
-            ClockTimeAtLastBounce[i] = UnixTime();                  // When ball last hit ground state
-            Dampening[i]             = 0.90 - i / pow(_cBalls, 2);  // Bounciness of this ball
-            BallSpeed[i]             = InitialBallSpeed(Height[i]); // Don't dampen initial launch
-            Colors[i]                = ballColors[i % ARRAYSIZE(ballColors) ];
+            _balls.Spawn(cLength - 1,                                   // Start at the top
+                         0.0f,                                          // ...at rest
+                         ballColors[i % ARRAYSIZE(ballColors)],
+                         0.0f,                                          // Balls live forever
+                         0.90 - i / pow(_cBalls, 2));                   // Bounciness of this ball
         }
     }
 
@@ -84,47 +89,17 @@ class BouncingBallEffect
     //
     // Draw each of the balls.  When any ball settles with too little energy, it it "kicked" to restart it
 
-    virtual void Draw()
+    virtual void Draw(const FrameContext & frame)
     {
         if (_fadeRate != 0)
         {
             for (size_t i = 0; i < _cLength; i++)
-                FastLED.leds()[i].fadeToBlackBy(_fadeRate);
+                g_LEDs[i].fadeToBlackBy(_fadeRate);
         }
         else
-            FastLED.clear();
+            fill_solid(g_LEDs, _cLength, CRGB::Black);
         
-        // Draw each of the balls
-
-        for (size_t i = 0; i < _cBalls; i++)
-        {
-            double TimeSinceLastBounce = (UnixTime() - ClockTimeAtLastBounce[i]) / SpeedKnob;
-
-            // Use standard constant acceleration function - https://en.wikipedia.org/wiki/Acceleration
-            Height[i] = 0.5 * Gravity * pow(TimeSinceLastBounce, 2.0) + BallSpeed[i] * TimeSinceLastBounce;
-
-            // Ball hits ground - bounce!
-            if (Height[i] < 0)
-            {
-                Height[i] = 0;
-                BallSpeed[i] = Dampening[i] * BallSpeed[i];
-                ClockTimeAtLastBounce[i] = Time();
-
-                if (BallSpeed[i] < 0.01)
-                    BallSpeed[i] = InitialBallSpeed(StartHeight) * Dampening[i];
-            }
-
-            size_t position = (size_t)(Height[i] * (_cLength - 1) / StartHeight);
-
-            FastLED.leds()[position]   += Colors[i];
-            FastLED.leds()[position+1] += Colors[i];
-
-            if (_bMirrored)
-            {
-                FastLED.leds()[_cLength - 1 - position] += Colors[i];
-                FastLED.leds()[_cLength - position]     += Colors[i];
-            }
-        }
-        delay(20);
+        _balls.Update(frame);
+        _balls.Render(Sequential, _bMirrored);
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,418 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        clocksync.h
+//
+// Description:
+//
+//   Keeps several controllers on one timebase so their effects stay in phase
+//   without streaming pixels.  One board (or a host) answers time requests;
+//   the others estimate their offset and drift from it, NTP style.  Uses only
+//   BSD sockets, so it builds on the ESP32 (lwIP) and on a Linux host.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <time.h>
+
+#ifndef HOST_ESP_TIMER                  // Shared with the other portable network headers
+#define HOST_ESP_TIMER
+inline int64_t esp_timer_get_time()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+#endif
+
+#include "timesource.h"
+
+// ClockSyncPacket
+//
+// A request carries the client's send time; the reply comes back with the server's receive and
+// transmit times filled in.  Little-endian, all times in microseconds on the sender's own clock.
+
+#pragma pack(push, 1)
+struct ClockSyncPacket
+{
+    static const uint32_t MagicValue = 0x3143444E;      // "NDC1"
+
+    uint32_t Magic;
+    uint32_t Sequence;
+    int64_t  Originate;                 // Client, request sent
+    int64_t  Receive;                   // Server, request received
+    int64_t  Transmit;                  // Server, reply sent
+};
+#pragma pack(pop)
+
+static const uint16_t ClockSyncPort = 49153;
+
+typedef int64_t (*LocalClock)();        // Normally esp_timer_get_time; host tests pass a skewed one
+
+// OpenClockSyncSocket
+//
+// UDP socket bound to port (0 for any), with reads that time out so callers can get on with
+// other work
+
+inline int OpenClockSyncSocket(uint16_t port, uint32_t timeoutMicros)
+{
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0)
+        return -1;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(s, (sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        close(s);
+        return -1;
+    }
+
+    timeval timeout = { 0, (long) timeoutMicros };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return s;
+}
+
+// ClockSyncServer
+//
+// Answers time requests from its own clock, which becomes the shared timebase.  Its own frame
+// clock needs no time source.
+
+class ClockSyncServer
+{
+  private:
+
+    int        _socket;
+    LocalClock _clock;
+    uint32_t   _cRequests;
+
+#ifdef ARDUINO
+    static void ServerTaskEntry(void * pv)
+    {
+        ClockSyncServer * pThis = (ClockSyncServer *) pv;
+        for (;;)
+            pThis->Service();
+    }
+#endif
+
+  public:
+
+    ClockSyncServer(LocalClock clock = esp_timer_get_time)
+        : _socket(-1),
+          _clock(clock),
+          _cRequests(0)
+    {
+    }
+
+    virtual ~ClockSyncServer()
+    {
+        if (_socket >= 0)
+            close(_socket);
+    }
+
+    bool Open(uint16_t port = ClockSyncPort)
+    {
+        _socket = OpenClockSyncSocket(port, 100000);
+        return _socket >= 0;
+    }
+
+#ifdef ARDUINO
+    bool Start(uint16_t port = ClockSyncPort, int core = 0, UBaseType_t priority = 3)
+    {
+        if (!Open(port))
+            return false;
+        return xTaskCreatePinnedToCore(ServerTaskEntry, "Clock Server", 3072, this, priority, nullptr, core) == pdPASS;
+    }
+#endif
+
+    // Service
+    //
+    // Answers one request; returns false if none came within 100ms.  The receive time is taken
+    // as soon as recvfrom returns and the transmit time just before sendto, so time spent in
+    // between doesn't count against the client's round trip.
+
+    bool Service()
+    {
+        ClockSyncPacket packet;
+        sockaddr_in     from;
+        socklen_t       cbFrom = sizeof(from);
+
+        ssize_t cb = recvfrom(_socket, &packet, sizeof(packet), 0, (sockaddr *) &from, &cbFrom);
+        int64_t received = _clock();
+        if (cb < 0)
+            return false;
+        if (cb != sizeof(packet) || packet.Magic != ClockSyncPacket::MagicValue)
+            return true;
+
+        packet.Receive  = received;
+        packet.Transmit = _clock();
+        sendto(_socket, &packet, sizeof(packet), 0, (sockaddr *) &from, cbFrom);
+        _cRequests++;
+        return true;
+    }
+
+    uint32_t Requests() const { return _cRequests; }
+};
+
+// ClockSync
+//
+// Client side.  Each exchange gives an offset sample, ((T2 - T1) + (T3 - T4)) / 2, that's off by
+// at most half the round trip's asymmetry; samples whose round trip is well above the best seen
+// recently were queued somewhere and are thrown away.  The good ones steer a small phase-locked
+// loop: the phase error nudges the offset, and its integral trims the drift estimate, so between
+// samples the model keeps tracking a crystal that runs fast or slow.
+//
+// The model is written by the sync task and read by the render loop, so it's published with a
+// sequence count that readers retry on.
+
+class ClockSync : public TimeSource
+{
+  public:
+
+    static const uint32_t FastIntervalMicros = 100000;      // While first locking on
+    static const uint32_t IntervalMicros     = 500000;
+    static const uint32_t FastSamples        = 16;
+    static const int64_t  StepMicros         = 50000;       // Errors bigger than this are a restart, not drift
+
+  private:
+
+    int        _socket;
+    LocalClock _clock;
+    sockaddr_in _server;
+    uint32_t   _sequence;
+    int64_t    _sentAt;
+    int64_t    _nextRequest;
+
+    // The model: shared = local + _offset + _drift * (local - _reference)
+
+    uint32_t   _version;
+    int64_t    _offset;
+    int64_t    _reference;
+    double     _drift;
+    bool       _bLocked;
+
+    int64_t    _lastSample;             // Local time of the last good sample
+    int64_t    _minRoundTrip;
+    float      _phaseError;             // Smoothed absolute phase error seen by the loop, not measured skew
+    uint32_t   _cSamples;
+    uint32_t   _cSteps;                 // Times the model was reset instead of steered
+    uint32_t   _cRejected;
+
+#ifdef ARDUINO
+    static void ClientTaskEntry(void * pv)
+    {
+        ClockSync * pThis = (ClockSync *) pv;
+        for (;;)
+            pThis->Service();
+    }
+#endif
+
+    void Publish(int64_t offset, int64_t reference, double drift)
+    {
+        __atomic_add_fetch(&_version, 1, __ATOMIC_ACQ_REL);
+        _offset    = offset;
+        _reference = reference;
+        _drift     = drift;
+        _bLocked   = true;
+        __atomic_add_fetch(&_version, 1, __ATOMIC_RELEASE);
+    }
+
+    void AddSample(int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+    {
+        int64_t roundTrip = (t4 - t1) - (t3 - t2);
+        int64_t sample    = ((t2 - t1) + (t3 - t4)) / 2;
+        int64_t mid       = t1 + (t4 - t1) / 2;
+        if (roundTrip < 0)
+            roundTrip = 0;
+
+        // Best recent round trip, leaking upward so a route that gets slower is followed
+
+        bool bFirst = !_bLocked;
+        if (bFirst || roundTrip < _minRoundTrip)
+            _minRoundTrip = roundTrip;
+        else
+            _minRoundTrip += _minRoundTrip / 32 + 1;
+
+        if (!bFirst && roundTrip > 2 * _minRoundTrip + 1000)
+        {
+            _cRejected++;
+            return;
+        }
+
+        double predicted = _offset + _drift * (mid - _reference);
+        double error     = sample - predicted;
+
+        if (bFirst || error > StepMicros || error < -StepMicros)
+        {
+            Publish(sample, mid, bFirst ? 0.0 : _drift);
+            __atomic_add_fetch(&_cSteps, 1, __ATOMIC_RELEASE);     // After Publish, so the new model is what's read
+            _phaseError = 0;
+        }
+        else
+        {
+            const double PhaseGain     = 0.3;
+            const double FrequencyGain = 0.05;
+            const double MaxDrift      = 0.0005;             // 500ppm is far beyond any crystal
+
+            double drift = _drift;
+            if (mid > _lastSample)
+                drift += FrequencyGain * error / (mid - _lastSample);
+            drift = drift > MaxDrift ? MaxDrift : drift < -MaxDrift ? -MaxDrift : drift;
+
+            Publish((int64_t)(predicted + PhaseGain * error), mid, drift);
+            _phaseError += ((error < 0 ? -error : error) - _phaseError) / 8;
+        }
+
+        _lastSample = mid;
+        _cSamples++;
+    }
+
+  public:
+
+    ClockSync(LocalClock clock = esp_timer_get_time)
+        : _socket(-1),
+          _clock(clock),
+          _sequence(0),
+          _sentAt(0),
+          _nextRequest(0),
+          _version(0),
+          _offset(0),
+          _reference(0),
+          _drift(0),
+          _bLocked(false),
+          _lastSample(0),
+          _minRoundTrip(0),
+          _phaseError(0),
+          _cSamples(0),
+          _cSteps(0),
+          _cRejected(0)
+    {
+        memset(&_server, 0, sizeof(_server));
+    }
+
+    virtual ~ClockSync()
+    {
+        if (_socket >= 0)
+            close(_socket);
+    }
+
+    // Open
+    //
+    // serverAddress is a dotted IPv4 address.  Replies are waited for 10ms at a time.
+
+    bool Open(const char * serverAddress, uint16_t port = ClockSyncPort)
+    {
+        _server.sin_family      = AF_INET;
+        _server.sin_port        = htons(port);
+        _server.sin_addr.s_addr = inet_addr(serverAddress);
+
+        _socket = OpenClockSyncSocket(0, 10000);
+        return _socket >= 0;
+    }
+
+#ifdef ARDUINO
+    bool Start(const char * serverAddress, uint16_t port = ClockSyncPort, int core = 0, UBaseType_t priority = 3)
+    {
+        if (!Open(serverAddress, port))
+            return false;
+        return xTaskCreatePinnedToCore(ClientTaskEntry, "Clock Sync", 3072, this, priority, nullptr, core) == pdPASS;
+    }
+#endif
+
+    // Service
+    //
+    // Sends a request when one is due, then waits briefly for the answer to the latest one.
+    // Replies to older requests are ignored; their send time has already been overwritten.
+
+    void Service()
+    {
+        int64_t now = _clock();
+        if (now >= _nextRequest)
+        {
+            ClockSyncPacket request = { ClockSyncPacket::MagicValue, ++_sequence, 0, 0, 0 };
+            _sentAt = request.Originate = _clock();
+            sendto(_socket, &request, sizeof(request), 0, (sockaddr *) &_server, sizeof(_server));
+            _nextRequest = now + (_cSamples < FastSamples ? FastIntervalMicros : IntervalMicros);
+        }
+
+        ClockSyncPacket reply;
+        ssize_t cb      = recv(_socket, &reply, sizeof(reply), 0);
+        int64_t arrived = _clock();
+
+        if (cb == sizeof(reply) && reply.Magic == ClockSyncPacket::MagicValue && reply.Sequence == _sequence && reply.Originate == _sentAt)
+        {
+            _sentAt = 0;                                        // Only the first copy of a reply counts
+            AddSample(reply.Originate, reply.Receive, reply.Transmit, arrived);
+        }
+    }
+
+    // SharedMicros
+    //
+    // Our best estimate of the server's clock at the given local time; the local time itself
+    // until the first sample arrives
+
+    virtual int64_t SharedMicros(int64_t localMicros) const override
+    {
+        int64_t offset, reference;
+        double  drift;
+        bool    bLocked;
+        uint32_t version;
+
+        do
+        {
+            while ((version = __atomic_load_n(&_version, __ATOMIC_ACQUIRE)) & 1)
+                ;
+            offset    = _offset;
+            reference = _reference;
+            drift     = _drift;
+            bLocked   = _bLocked;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while (__atomic_load_n(&_version, __ATOMIC_RELAXED) != version);
+
+        if (!bLocked)
+            return localMicros;
+        return localMicros + offset + (int64_t)(drift * (localMicros - reference));
+    }
+
+    virtual uint32_t StepCount() const override
+    {
+        return __atomic_load_n(&_cSteps, __ATOMIC_ACQUIRE);
+    }
+
+    // IsSynchronized
+    //
+    // Locked on with a few samples, the latest within the last ten seconds
+
+    bool IsSynchronized(int64_t localMicros) const
+    {
+        return _cSamples >= 4 && localMicros - _lastSample < 10000000;
+    }
+
+    int64_t  OffsetMicros() const       { return _offset; }
+    float    DriftPPM() const           { return _drift * 1000000.0; }
+    float    PhaseErrorMicros() const   { return _phaseError; }
+    uint32_t RoundTripMicros() const    { return (uint32_t) _minRoundTrip; }
+    uint32_t Samples() const            { return _cSamples; }
+    uint32_t Rejected() const           { return _cRejected; }
+};
@@ -2,13 +2,14 @@
 //
 // NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
 //
-// File:                  
+// File:        comet.h
 //
 // Description:
 //
-//   
+//   Comets with fading tails that bounce back and forth along the strip
 //
 // History:     Sep-28-2020     davepl      Created
+//              Oct-19-2026     davepl      Multi-comet CometEffect with computed trails
 //
 //---------------------------------------------------------------------------
 
@@ -16,29 +17,156 @@
 #define FASTLED_INTERNAL
 #include <FastLED.h>
 
-void DrawComet()
+#include "ledgfx.h"
+#include "framecontext.h"
+
+// CometEffect
+//
+// Any number of comets (up to MaxComets), each with a sub-pixel position, its own speed, hue
+// drift and tail length.  Rather than fading the whole strip every frame and relying on what was
+// left behind, each tail is drawn fresh behind its head from a precomputed exponential falloff,
+// so only the pixels the comet actually covers are touched.  Tails fold back on themselves when
+// a comet bounces off either end.
+//
+// Where each comet is and what hue it has are worked out from the frame time, not built up frame
+// by frame, so controllers on a shared clock draw the same comets wherever they are in their
+// uptime.  The sparkle is reseeded from the frame time too, every 60th of a second.
+
+class CometEffect
+{
+  public:
+
+    static const size_t MaxComets = 8;
+    static const size_t MaxTrail  = 32;
+
+  private:
+
+    struct Comet
+    {
+        float   Start;                  // Back edge of the head at time zero, before any bouncing
+        float   Speed;                  // Pixels per second, sign is the direction it set off in
+        float   Size;                   // Width of the head in pixels
+        float   Hue;                    // Hue at time zero
+        float   HueDrift;               // Hue units per second
+        size_t  TrailLength;
+        byte    Falloff[MaxTrail];      // Brightness of each tail pixel behind the head
+    };
+
+    Comet      _comets[MaxComets];
+    size_t     _cComets;
+    size_t     _cLength;
+    byte       _sparkle;                // Chance out of 255 that a tail pixel drops out this frame
+    uint32_t   _seed;
+    FastRandom _random;                 // Owned and seeded from the time so the sparkle is repeatable
+
+    // Reflect a position that has run off either end back onto the strip
+
+    float Fold(float pos) const
+    {
+        float top = _cLength - 1.0f;
+        if (pos < 0.0f)
+            pos = -pos;
+        if (pos > top)
+            pos = 2.0f * top - pos;
+        return pos;
+    }
+
+  public:
+
+    CometEffect(size_t cLength, byte sparkle = 0, uint32_t seed = 1)
+        : _cComets(0),
+          _cLength(cLength),
+          _sparkle(sparkle),
+          _seed(seed),
+          _random(seed)
+    {
+    }
+
+    // AddComet
+    //
+    // Falloff is 255 at the head and decays exponentially to about 1% at the end of the tail.  The
+    // tail is kept shorter than the strip, since Fold() can only bounce it off one end.
+
+    bool AddComet(float position, float speed, byte hue = HUE_RED, float hueDrift = 0.0f, size_t trailLength = 10, float size = 1.0f)
+    {
+        if (_cComets == MaxComets)
+            return false;
+
+        Comet & comet      = _comets[_cComets++];
+        comet.Start        = position;
+        comet.Speed        = speed;
+        comet.Size         = size;
+        comet.Hue          = hue;
+        comet.HueDrift     = hueDrift;
+        comet.TrailLength  = min(trailLength, min(MaxTrail, _cLength ? _cLength - 1 : 0));
+
+        for (size_t k = 0; k < comet.TrailLength; k++)
+            comet.Falloff[k] = 255 * expf(-4.6f * (k + 1) / comet.TrailLength);
+
+        return true;
+    }
+
+    void Draw(const FrameContext & frame, PixelOrder order = Sequential)
+    {
+        double seconds = frame.Micros / 1000000.0;
+        _random.Seed(_seed + (uint32_t)(frame.Micros / 16667));
+
+        for (size_t i = 0; i < _cComets; i++)
+        {
+            const Comet & comet = _comets[i];
+            double limit = max(_cLength - comet.Size, 0.0f);
+
+            // Bouncing between 0 and limit is a triangle wave: unfold it into a line twice as long,
+            // find where the comet is on that, and fold the far half back
+
+            float position = 0.0f;
+            float speed    = comet.Speed;
+            if (limit > 0.0)
+            {
+                double travel = fmod(comet.Start + comet.Speed * seconds, 2.0 * limit);
+                if (travel < 0.0)
+                    travel += 2.0 * limit;
+                position = travel;
+                if (travel > limit)
+                {
+                    position = 2.0 * limit - travel;
+                    speed    = -speed;
+                }
+            }
+
+            float hue = fmod(comet.Hue + comet.HueDrift * seconds, 256.0);
+            if (hue < 0.0f)
+                hue += 256.0f;
+            CRGB color = CHSV((byte) hue, 255, 255);
+
+            DrawFanPixels(position, comet.Size, color, order);
+
+            // Tail pixels start right behind the head, on whichever side it's moving away from
+
+            float tail = speed >= 0.0f ? position - 1.0f : position + comet.Size;
+            float step = speed >= 0.0f ? -1.0f : 1.0f;
+
+            for (size_t k = 0; k < comet.TrailLength; k++, tail += step)
+            {
+                if (_sparkle && _random.Next(255) < _sparkle)
+                    continue;
+                DrawFanPixels(Fold(tail), 1.0f, CRGB(color).nscale8(comet.Falloff[k]), order);
+            }
+        }
+    }
+};
+
+// DrawComet
+//
+// The original single comet: a five pixel head that moves a pixel every 30ms with a sparkly tail
+
+void DrawComet(const FrameContext & frame)
 {
-    const byte fadeAmt = 128;
     const int cometSize = 5;
     const int deltaHue  = 4;
 
-    static byte hue = HUE_RED;
-    static int iDirection = 1;
-    static int iPos = 0;
-
-    hue += deltaHue;
-
-    iPos += iDirection;
-    if (iPos == (FastLED.count() - cometSize) || iPos == 0)
-        iDirection *= -1;
-    
-    for (int i = 0; i < cometSize; i++)
-        FastLED.leds()[iPos + i].setHue(hue);
-    
-    // Randomly fade the LEDs
-    for (int j = 0; j < FastLED.count(); j++)
-        if (random(10) > 5)
-            FastLED.leds()[j] = FastLED.leds()[j].fadeToBlackBy(fadeAmt);  
-
-    delay(30);
-}
\ No newline at end of file
+    static CometEffect comet(NUM_LEDS, 128);
+    static bool bStarted = comet.AddComet(0, 1000.0f / 30, HUE_RED, deltaHue * 1000.0f / 30, 12, cometSize);
+
+    comet.Draw(frame);
+}
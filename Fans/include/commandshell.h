@@ -0,0 +1,170 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        commandshell.h
+//
+// Description:
+//
+//   Line-oriented command interpreter on the serial port, for tuning the
+//   effects without reflashing.  Polled once per frame; never blocks and
+//   never allocates.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+
+// ShellCommand
+//
+// One entry in the command table.  The handler gets the line split into words, command first.
+
+struct ShellCommand
+{
+    const char * Name;
+    const char * Help;
+    void      (* Handler)(int argc, char * argv[]);
+};
+
+// CommandShell
+//
+// Characters are collected into a fixed line buffer as they arrive; nothing is parsed until a
+// line ends, so an idle port costs one available() check per frame.  Lines are split in place
+// and dispatched from Poll(), which the main loop calls between frames, so handlers can change
+// anything the frame uses without it changing underneath a frame in progress.
+
+class CommandShell
+{
+  public:
+
+    static const size_t MaxLine = 80;
+    static const int    MaxArgs = 8;
+
+  private:
+
+    const ShellCommand * _commands;
+    size_t               _cCommands;
+    char                 _line[MaxLine];
+    size_t               _cLine;
+    bool                 _bOverflow;            // Line too long; discard until it ends
+
+    void Help()
+    {
+        for (size_t i = 0; i < _cCommands; i++)
+            Serial.printf("  %-8s %s\n", _commands[i].Name, _commands[i].Help);
+        Serial.printf("  %-8s %s\n", "help", "List commands");
+    }
+
+    void Dispatch()
+    {
+        char * argv[MaxArgs];
+        int    argc = 0;
+
+        // Each word ends at the separator zeroed ahead of the next one, or at the end of the line.
+        // A line with more words than fit is turned away rather than handed over cut short.
+
+        for (char * p = _line; *p; )
+        {
+            while (*p == ' ' || *p == '\t')
+                *p++ = 0;
+            if (!*p)
+                break;
+            if (argc == MaxArgs)
+            {
+                Serial.println("Too many words");
+                return;
+            }
+            argv[argc++] = p;
+            while (*p && *p != ' ' && *p != '\t')
+                p++;
+        }
+        if (argc == 0)
+            return;
+
+        if (!strcmp(argv[0], "help") || !strcmp(argv[0], "?"))
+        {
+            Help();
+            return;
+        }
+
+        for (size_t i = 0; i < _cCommands; i++)
+        {
+            if (!strcmp(argv[0], _commands[i].Name))
+            {
+                _commands[i].Handler(argc, argv);
+                return;
+            }
+        }
+        Serial.printf("Unknown command '%s', try help\n", argv[0]);
+    }
+
+  public:
+
+    CommandShell(const ShellCommand * commands, size_t cCommands)
+        : _commands(commands),
+          _cCommands(cCommands),
+          _cLine(0),
+          _bOverflow(false)
+    {
+    }
+
+    // Poll
+    //
+    // Takes whatever has arrived and runs any lines it completes.  Returns true if a command ran.
+
+    bool Poll()
+    {
+        bool bRan = false;
+
+        for (int cb = Serial.available(); cb > 0; cb--)
+        {
+            int c = Serial.read();
+            if (c < 0)
+                break;
+
+            if (c == '\r' || c == '\n')
+            {
+                if (_bOverflow)
+                    Serial.println("Line too long");
+                else if (_cLine)
+                {
+                    _line[_cLine] = 0;
+                    Dispatch();
+                    bRan = true;
+                }
+                _cLine     = 0;
+                _bOverflow = false;
+            }
+            else if (c == '\b' || c == 0x7F)
+            {
+                if (_cLine)
+                    _cLine--;
+            }
+            else if (_cLine < MaxLine - 1)
+            {
+                _line[_cLine++] = (char) c;
+            }
+            else
+            {
+                _bOverflow = true;
+            }
+        }
+        return bRan;
+    }
+};
+
+// ParseInt
+//
+// Strict decimal parse for command arguments: the whole word must be a number within [lo, hi]
+
+inline bool ParseInt(const char * text, long lo, long hi, long & value)
+{
+    char * end;
+    value = strtol(text, &end, 10);
+    return end != text && *end == 0 && value >= lo && value <= hi;
+}
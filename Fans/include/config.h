@@ -0,0 +1,278 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        config.h
+//
+// Description:
+//
+//   Settings that survive a reboot.  Kept as one small binary block with a
+//   version and checksum, restored with a single read at boot, and written
+//   back only after changes have settled so flash isn't worn by every tweak.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#else
+#include <stdio.h>
+#endif
+
+#include "crc16.h"
+
+// FanSettings
+//
+// The settings themselves.  New fields only ever go on the end: a block saved by older firmware
+// is shorter, so its fields are restored and the new ones keep their defaults.
+
+#pragma pack(push, 1)
+struct FanSettings
+{
+    uint8_t  Brightness;
+    int8_t   Effect;                    // Index into the effect table, or -1 for the default
+    uint16_t TargetFPS;
+    uint32_t PowerLimit;                // mW, or 0 for no limit
+    uint8_t  FireCooling;               // 0 for the fire effects' own settings
+    uint8_t  FireSparking;
+};
+
+// ConfigHeader
+//
+// Precedes the settings in storage.  Size is how many bytes of settings follow, and the CRC
+// covers exactly those.
+
+struct ConfigHeader
+{
+    static const uint32_t MagicValue     = 0x3153444E;      // "NDS1"
+    static const uint16_t CurrentVersion = 1;
+
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t Size;
+    uint16_t Crc;
+};
+#pragma pack(pop)
+
+// ConfigStore
+//
+// Somewhere to keep one block of bytes
+
+class ConfigStore
+{
+  public:
+
+    virtual ~ConfigStore()
+    {
+    }
+
+    // Read returns the number of bytes read, 0 if there's nothing stored
+
+    virtual size_t Read(void * pData, size_t cbMax) = 0;
+    virtual bool   Write(const void * pData, size_t cb) = 0;
+};
+
+#ifdef ARDUINO
+
+// NVSConfigStore
+//
+// One blob in the ESP32's NVS partition.  NVS spreads writes across its pages itself, so what
+// matters for wear is how often we write, which PersistentConfig keeps down.
+
+class NVSConfigStore : public ConfigStore
+{
+    const char * _namespace;
+    const char * _key;
+
+  public:
+
+    NVSConfigStore(const char * nameSpace = "nightdriver", const char * key = "settings")
+        : _namespace(nameSpace),
+          _key(key)
+    {
+    }
+
+    virtual size_t Read(void * pData, size_t cbMax) override
+    {
+        Preferences prefs;
+        if (!prefs.begin(_namespace, true))
+            return 0;
+        size_t cb = prefs.getBytesLength(_key);
+        cb = cb > cbMax ? 0 : prefs.getBytes(_key, pData, cb);
+        prefs.end();
+        return cb;
+    }
+
+    virtual bool Write(const void * pData, size_t cb) override
+    {
+        Preferences prefs;
+        if (!prefs.begin(_namespace, false))
+            return false;
+        bool bOK = prefs.putBytes(_key, pData, cb) == cb;
+        prefs.end();
+        return bOK;
+    }
+};
+
+#else
+
+// FileConfigStore
+//
+// Host stand-in for NVS, so the config logic can be exercised without a board
+
+class FileConfigStore : public ConfigStore
+{
+    const char * _path;
+
+  public:
+
+    FileConfigStore(const char * path)
+        : _path(path)
+    {
+    }
+
+    virtual size_t Read(void * pData, size_t cbMax) override
+    {
+        FILE * f = fopen(_path, "rb");
+        if (!f)
+            return 0;
+        size_t cb = fread(pData, 1, cbMax, f);
+        fclose(f);
+        return cb;
+    }
+
+    virtual bool Write(const void * pData, size_t cb) override
+    {
+        FILE * f = fopen(_path, "wb");
+        if (!f)
+            return false;
+        bool bOK = fwrite(pData, 1, cb, f) == cb;
+        return fclose(f) == 0 && bOK;
+    }
+};
+
+#endif
+
+// PersistentConfig
+//
+// Load() is one read into a fixed buffer and a checksum; anything that doesn't check out leaves
+// the defaults in place.  After that, Update() is called once a frame with the live settings.
+// A change is only written once nothing has changed for DebounceMicros, so dragging brightness
+// through twenty values costs one write, and never sooner than MinIntervalMicros after the last
+// write, so a runaway script can't burn through the flash.
+
+class PersistentConfig
+{
+  public:
+
+    static const int64_t DebounceMicros    = 5000000;
+    static const int64_t MinIntervalMicros = 30000000;
+
+  private:
+
+    ConfigStore & _store;
+    FanSettings   _saved;               // What's in storage
+    FanSettings   _pending;             // Latest live settings seen
+    int64_t       _changedAt;
+    int64_t       _writtenAt;
+    bool          _bWritten;
+    uint32_t      _cWrites;
+
+  public:
+
+    PersistentConfig(ConfigStore & store)
+        : _store(store),
+          _changedAt(0),
+          _writtenAt(0),
+          _bWritten(false),
+          _cWrites(0)
+    {
+        memset(&_saved, 0, sizeof(_saved));
+        memset(&_pending, 0, sizeof(_pending));
+    }
+
+    // Load
+    //
+    // Overwrites settings (which should hold the defaults) with whatever was saved.  Returns
+    // false if nothing usable was stored.
+
+    bool Load(FanSettings & settings)
+    {
+        uint8_t buffer[sizeof(ConfigHeader) + sizeof(FanSettings)];
+        size_t  cb = _store.Read(buffer, sizeof(buffer));
+
+        ConfigHeader header;
+        bool bOK = cb >= sizeof(header);
+        if (bOK)
+        {
+            memcpy(&header, buffer, sizeof(header));
+            bOK = header.Magic == ConfigHeader::MagicValue
+               && header.Version <= ConfigHeader::CurrentVersion
+               && header.Size <= sizeof(FanSettings)
+               && cb >= sizeof(header) + header.Size
+               && Crc16(0xFFFF, buffer + sizeof(header), header.Size) == header.Crc;
+        }
+        if (bOK)
+            memcpy(&settings, buffer + sizeof(header), header.Size);
+
+        _saved   = settings;
+        _pending = settings;
+        return bOK;
+    }
+
+    // Update
+    //
+    // Notes the live settings and writes them if they've settled.  Returns true if it wrote.
+
+    bool Update(const FanSettings & live, int64_t now)
+    {
+        if (memcmp(&live, &_pending, sizeof(live)))
+        {
+            _pending   = live;
+            _changedAt = now;
+        }
+
+        if (!memcmp(&_pending, &_saved, sizeof(_saved)))
+            return false;
+        if (now - _changedAt < DebounceMicros)
+            return false;
+        if (_bWritten && now - _writtenAt < MinIntervalMicros)
+            return false;
+
+        return Flush(now);
+    }
+
+    // Flush
+    //
+    // Writes the pending settings now, if they differ from what's stored
+
+    bool Flush(int64_t now)
+    {
+        if (!memcmp(&_pending, &_saved, sizeof(_saved)))
+            return false;
+
+        uint8_t buffer[sizeof(ConfigHeader) + sizeof(FanSettings)];
+        ConfigHeader header = { ConfigHeader::MagicValue, ConfigHeader::CurrentVersion, (uint16_t) sizeof(FanSettings), 0 };
+        header.Crc = Crc16(0xFFFF, (const uint8_t *) &_pending, sizeof(_pending));
+        memcpy(buffer, &header, sizeof(header));
+        memcpy(buffer + sizeof(header), &_pending, sizeof(_pending));
+
+        _writtenAt = now;
+        _bWritten  = true;
+        if (!_store.Write(buffer, sizeof(buffer)))
+            return false;
+
+        _saved = _pending;
+        _cWrites++;
+        return true;
+    }
+
+    bool     IsDirty() const { return memcmp(&_pending, &_saved, sizeof(_saved)) != 0; }
+    uint32_t Writes() const  { return _cWrites; }
+};
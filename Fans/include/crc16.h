@@ -0,0 +1,39 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        crc16.h
+//
+// Description:
+//
+//   CRC-16/CCITT-FALSE, used to check serial frames and stored settings
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Crc16
+//
+// CCITT polynomial 0x1021, MSB first, folded a byte at a time without a table
+
+inline uint16_t Crc16(uint16_t crc, uint8_t b)
+{
+    crc  = (uint8_t)(crc >> 8) | (crc << 8);
+    crc ^= b;
+    crc ^= (uint8_t)(crc & 0xFF) >> 4;
+    crc ^= crc << 12;
+    crc ^= (crc & 0xFF) << 5;
+    return crc;
+}
+
+inline uint16_t Crc16(uint16_t crc, const uint8_t * p, size_t cb)
+{
+    while (cb--)
+        crc = Crc16(crc, *p++);
+    return crc;
+}
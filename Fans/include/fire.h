@@ -15,6 +15,7 @@
 #include <FastLED.h>
 
 #include "ledgfx.h"
+#include "framecontext.h"
 
 class FireEffect
 {
@@ -24,6 +25,8 @@ class FireEffect
     int     Sparks;             // How many sparks will be attempted each frame
     int     SparkHeight;        // If created, max height for a spark
     int     Sparking;           // Probability of a spark each attempt
+    int     DefaultCooling;     // What the flame was built with, for Tune() to go back to
+    int     DefaultSparking;
     bool    bReversed;          // If reversed we draw from 0 outwards
     bool    bMirrored;          // If mirrored we split and duplicate the drawing
 
@@ -46,6 +49,8 @@ class FireEffect
           Sparks(sparks),
           SparkHeight(sparkHeight),
           Sparking(sparking),
+          DefaultCooling(cooling),
+          DefaultSparking(sparking),
           bReversed(breversed),
           bMirrored(bmirrored)
     {
@@ -55,16 +60,26 @@ class FireEffect
         heat = new byte[size] { 0 };
     }
 
+    // Tune
+    //
+    // Changes the flame while it's running; zero puts a setting back to what the flame was built with
+
+    void Tune(int cooling, int sparking)
+    {
+        Cooling  = cooling > 0 ? cooling : DefaultCooling;
+        Sparking = sparking > 0 ? sparking : DefaultSparking;
+    }
+
     virtual ~FireEffect()
     {
         delete [] heat;
     }
 
-    virtual void DrawFire(PixelOrder order = Sequential)
+    virtual void DrawFire(const FrameContext & frame, PixelOrder order = Sequential)
     {
         // First cool each cell by a litle bit
         for (int i = 0; i < Size; i++)
-            heat[i] = max(0L, heat[i] - random(0, ((Cooling * 10) / Size) + 2));
+            heat[i] = max(0L, heat[i] - (long) frame.Random.Next(((Cooling * 10) / Size) + 2));
 
         // Next drift heat up and diffuse it a little bit
         for (int i = 0; i < Size; i++)
@@ -78,10 +93,10 @@ class FireEffect
 
         for (int i = 0 ; i < Sparks; i++)
         {
-            if (random(255) < Sparking)
+            if (frame.Random.Next(255) < (uint32_t) Sparking)
             {
-                int y = Size - 1 - random(SparkHeight);
-                heat[y] = heat[y] + random(160, 255);       // Can roll over which actually looks good!
+                int y = Size - 1 - frame.Random.Next(SparkHeight);
+                heat[y] = heat[y] + frame.Random.Next(160, 255);       // Can roll over which actually looks good!
             }
         }
 
@@ -0,0 +1,413 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        framecodec.h
+//
+// Description:
+//
+//   Compact encoding for sequences of LED frames, for streaming them over the
+//   network or recording them to flash.  No Arduino dependencies, so the same
+//   code is benchmarked on the host.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Encoded frame format
+//
+//   type byte         FrameKey or FrameDelta
+//   tokens...         (zero run, literal run, literal bytes) repeated until the frame is covered
+//
+// Run lengths are LEB128 varints.  The bytes being run-length coded are the frame XORed against a
+// reference: for a delta frame that's the previous frame, so anything that didn't change is zero;
+// for a keyframe it's the pixel before, so solid and black areas are zero.  Mostly-dark content
+// and slowly changing content (fire tails, twinkles) both turn into long zero runs.
+
+enum FrameCodecType : uint8_t
+{
+    FrameKey   = 0x4B,                  // 'K'
+    FrameDelta = 0x44                   // 'D'
+};
+
+// MaxEncodedSize
+//
+// Worst case output for a frame of cBytes: the type byte, plus the bytes themselves as a single
+// literal run, plus the varints for that run.  Splitting a literal never costs more than the zeros
+// it skips, so this holds for any content.
+
+inline size_t MaxEncodedSize(size_t cBytes)
+{
+    return 1 + cBytes + 10;
+}
+
+// FrameEncoder
+//
+// Keeps a copy of the last frame it encoded and sends a keyframe every keyInterval frames (and
+// whenever asked), so a receiver that joins late or loses data can resync.
+
+class FrameEncoder
+{
+  private:
+
+    uint8_t * _previous;
+    size_t    _cBytes;
+    uint32_t  _keyInterval;
+    uint32_t  _sinceKey;
+
+    // A zero run splitting a literal costs up to four bytes of tokens (one for the zero count, up
+    // to three for the next literal count), so shorter ones stay in the literal
+
+    static const size_t MinZeroRun = 4;
+
+    // Residual for byte i: XOR against the previous frame, or for keyframes the previous pixel
+
+    uint8_t Residual(const uint8_t * pFrame, size_t i, bool bKey) const
+    {
+        if (bKey)
+            return pFrame[i] ^ (i < 3 ? 0 : pFrame[i - 3]);
+        return pFrame[i] ^ _previous[i];
+    }
+
+    static uint8_t * PutVarint(uint8_t * p, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            *p++ = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        *p++ = (uint8_t) value;
+        return p;
+    }
+
+  public:
+
+    FrameEncoder(size_t cBytes, uint32_t keyInterval = 60)
+        : _cBytes(cBytes),
+          _keyInterval(keyInterval),
+          _sinceKey(keyInterval)                // So the first frame is a keyframe
+    {
+        _previous = new uint8_t[cBytes];
+        memset(_previous, 0, cBytes);
+    }
+
+    virtual ~FrameEncoder()
+    {
+        delete [] _previous;
+    }
+
+    void ForceKeyframe()
+    {
+        _sinceKey = _keyInterval;
+    }
+
+    // Encode
+    //
+    // pOut must have room for MaxEncodedSize(cBytes).  Returns the number of bytes written.
+
+    size_t Encode(const uint8_t * pFrame, uint8_t * pOut)
+    {
+        bool bKey = _sinceKey >= _keyInterval;
+        _sinceKey = bKey ? 1 : _sinceKey + 1;
+
+        uint8_t * p = pOut;
+        *p++ = bKey ? FrameKey : FrameDelta;
+
+        size_t i = 0;
+        while (i < _cBytes)
+        {
+            // Count zeros from here
+
+            size_t zeros = 0;
+            while (i + zeros < _cBytes && Residual(pFrame, i + zeros, bKey) == 0)
+                zeros++;
+
+            // Then literals, until a zero run long enough to be worth its own token
+
+            size_t start = i + zeros;
+            size_t end   = start;
+            while (end < _cBytes)
+            {
+                size_t run = 0;
+                while (end + run < _cBytes && run < MinZeroRun && Residual(pFrame, end + run, bKey) == 0)
+                    run++;
+                if (run == MinZeroRun)
+                    break;
+                end += run ? run : 1;
+            }
+
+            p = PutVarint(p, zeros);
+            p = PutVarint(p, end - start);
+            for (size_t j = start; j < end; j++)
+                *p++ = Residual(pFrame, j, bKey);
+
+            i = end;
+        }
+
+        memcpy(_previous, pFrame, _cBytes);
+        return p - pOut;
+    }
+};
+
+// FrameDecoder
+//
+// Decodes a stream of encoded frames incrementally, straight into the framebuffer it's given,
+// which must still hold the previous frame when a delta arrives.  Input can be fed in pieces of
+// any size (a datagram, a flash page, a few bytes from a UART); all the state it needs between
+// pieces is a handful of integers.
+
+class FrameDecoder
+{
+  public:
+
+    enum Result
+    {
+        NeedMore,                       // Consumed everything, frame not finished yet
+        FrameComplete,                  // A frame just finished; the rest of the input wasn't consumed
+        Error                           // Bad type byte or a run past the end of the frame
+    };
+
+  private:
+
+    enum State { ReadType, ReadZeros, ReadLiteralCount, ReadLiterals };
+
+    uint8_t * _pFrame;
+    size_t    _cBytes;
+    State     _state;
+    bool      _bKey;
+    size_t    _pos;                     // Next byte of the frame to write
+    uint32_t  _varint;
+    uint8_t   _shift;
+    size_t    _remaining;               // Literal bytes still to come in this run
+
+    // Undo the residual: previous pixel for keyframes, previous frame (in place) for deltas
+
+    void Write(uint8_t residual)
+    {
+        if (_bKey)
+            _pFrame[_pos] = residual ^ (_pos < 3 ? 0 : _pFrame[_pos - 3]);
+        else
+            _pFrame[_pos] ^= residual;
+        _pos++;
+    }
+
+    void ZeroRun(size_t count)
+    {
+        if (_bKey)
+        {
+            for (size_t end = _pos + count; _pos < end; _pos++)
+                _pFrame[_pos] = _pos < 3 ? 0 : _pFrame[_pos - 3];
+        }
+        else
+        {
+            _pos += count;              // Unchanged from the previous frame
+        }
+    }
+
+  public:
+
+    FrameDecoder(uint8_t * pFrame, size_t cBytes)
+        : _pFrame(pFrame),
+          _cBytes(cBytes),
+          _state(ReadType),
+          _bKey(false),
+          _pos(0),
+          _varint(0),
+          _shift(0),
+          _remaining(0)
+    {
+    }
+
+    // Reset
+    //
+    // Abandons any partly decoded frame; the next byte fed should be a type byte
+
+    void Reset()
+    {
+        _state = ReadType;
+    }
+
+    // Feed
+    //
+    // Consumes input until it runs out or a frame completes.  cbUsed says how much was consumed.
+
+    Result Feed(const uint8_t * pData, size_t cb, size_t & cbUsed)
+    {
+        const uint8_t * p    = pData;
+        const uint8_t * pEnd = pData + cb;
+
+        while (p < pEnd)
+        {
+            switch (_state)
+            {
+                case ReadType:
+                    if (*p != FrameKey && *p != FrameDelta)
+                    {
+                        cbUsed = p - pData;
+                        return Error;
+                    }
+                    _bKey   = *p++ == FrameKey;
+                    _pos    = 0;
+                    _varint = 0;
+                    _shift  = 0;
+                    _state  = ReadZeros;
+                    break;
+
+                case ReadZeros:
+                case ReadLiteralCount:
+                {
+                    uint8_t b = *p++;
+                    if (_shift == 28 && b > 0x0F)                   // A fifth byte only has room for bits 28-31
+                    {
+                        cbUsed = p - pData;
+                        _state = ReadType;
+                        return Error;
+                    }
+                    _varint |= (uint32_t)(b & 0x7F) << _shift;
+                    _shift  += 7;
+                    if (b & 0x80)
+                        break;
+
+                    uint32_t value = _varint;
+                    _varint = 0;
+                    _shift  = 0;
+
+                    if (value > _cBytes - _pos)
+                    {
+                        cbUsed = p - pData;
+                        _state = ReadType;
+                        return Error;
+                    }
+
+                    if (_state == ReadZeros)
+                    {
+                        ZeroRun(value);
+                        _state = ReadLiteralCount;
+                    }
+                    else if (value)
+                    {
+                        _remaining = value;
+                        _state     = ReadLiterals;
+                    }
+                    else
+                    {
+                        _state = ReadZeros;
+                    }
+                    break;
+                }
+
+                case ReadLiterals:
+                    while (p < pEnd && _remaining)
+                    {
+                        Write(*p++);
+                        _remaining--;
+                    }
+                    if (!_remaining)
+                        _state = ReadZeros;
+                    break;
+            }
+
+            // Each (zeros, literals) token pair ends on a frame boundary when the frame is full
+
+            if (_pos == _cBytes && _state == ReadZeros)
+            {
+                _state = ReadType;
+                cbUsed = p - pData;
+                return FrameComplete;
+            }
+        }
+
+        cbUsed = p - pData;
+        return NeedMore;
+    }
+};
+
+// CodecStats
+//
+// Results from BenchmarkFrameCodec.  Throughput is in megabytes of raw frame data per second.
+
+struct CodecStats
+{
+    float  EncodeMBps;
+    float  DecodeMBps;
+    float  Ratio;                       // Raw bytes over encoded bytes
+    size_t EncodedBytes;
+    bool   bRoundTrip;                  // Every decoded frame matched its original
+};
+
+// BenchmarkFrameCodec
+//
+// Encodes cFrames consecutive frames of cBytes each from pFrames, then decodes them all again and
+// checks they match.  The clock is passed in (esp_timer_get_time on the device) so this stays free
+// of platform headers.  Allocates its scratch buffers for the duration of the call.
+
+inline CodecStats BenchmarkFrameCodec(const uint8_t * pFrames, size_t cFrames, size_t cBytes, int64_t (*clock)(), uint32_t keyInterval = 60)
+{
+    CodecStats stats = { 0.0f, 0.0f, 0.0f, 0, true };
+
+    size_t    cbMax    = MaxEncodedSize(cBytes);
+    uint8_t * pEncoded = new uint8_t[cbMax * cFrames];
+    size_t  * pSizes   = new size_t[cFrames];
+    uint8_t * pFrame   = new uint8_t[cBytes];
+
+    FrameEncoder encoder(cBytes, keyInterval);
+    uint8_t    * p = pEncoded;
+
+    int64_t start = clock();
+    for (size_t i = 0; i < cFrames; i++)
+    {
+        pSizes[i] = encoder.Encode(pFrames + i * cBytes, p);
+        p += pSizes[i];
+    }
+    int64_t encodeMicros = clock() - start;
+    stats.EncodedBytes = p - pEncoded;
+
+    // Decode the whole run as one stream, fed in modest pieces the way a socket or UART hands it over
+
+    FrameDecoder decoder(pFrame, cBytes);
+    const size_t Chunk = 256;
+    size_t  iFrame   = 0;
+    int64_t checking = 0;
+
+    start = clock();
+    for (size_t offset = 0; offset < stats.EncodedBytes; )
+    {
+        size_t cb = stats.EncodedBytes - offset < Chunk ? stats.EncodedBytes - offset : Chunk;
+        size_t used;
+        FrameDecoder::Result result = decoder.Feed(pEncoded + offset, cb, used);
+        offset += used;
+
+        if (result == FrameDecoder::Error)
+        {
+            stats.bRoundTrip = false;
+            break;
+        }
+        if (result == FrameDecoder::FrameComplete)
+        {
+            int64_t t = clock();
+            if (iFrame >= cFrames || memcmp(pFrame, pFrames + iFrame * cBytes, cBytes))
+                stats.bRoundTrip = false;
+            iFrame++;
+            checking += clock() - t;
+        }
+    }
+    int64_t decodeMicros = clock() - start - checking;
+    if (iFrame != cFrames)
+        stats.bRoundTrip = false;
+
+    float megabytes  = (float) cBytes * cFrames / 1000000.0f;
+    stats.EncodeMBps = encodeMicros > 0 ? megabytes * 1000000.0f / encodeMicros : 0.0f;
+    stats.DecodeMBps = decodeMicros > 0 ? megabytes * 1000000.0f / decodeMicros : 0.0f;
+    stats.Ratio      = stats.EncodedBytes ? (float) cBytes * cFrames / stats.EncodedBytes : 0.0f;
+
+    delete [] pEncoded;
+    delete [] pSizes;
+    delete [] pFrame;
+    return stats;
+}
@@ -0,0 +1,186 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        framecontext.h
+//
+// Description:
+//
+//   Per-frame timing and random state that is handed to every draw call.  The
+//   clock is read exactly once per frame so that all effects see the same time.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+#include <esp_timer.h>                  // For esp_timer_get_time, monotonic uS since boot
+
+#include "timesource.h"
+
+// FastRandom
+//
+// Small xorshift32 generator.  An effect that wants repeatable output can own one with a fixed
+// seed; everyone else just uses the one that comes along with the frame.
+
+class FastRandom
+{
+  private:
+
+    uint32_t _state;
+
+  public:
+
+    FastRandom(uint32_t seed = 0x2545F491) : _state(seed ? seed : 1)
+    {
+    }
+
+    void Seed(uint32_t seed)
+    {
+        _state = seed ? seed : 1;       // Zero is the one state xorshift can never leave
+    }
+
+    uint32_t Next()
+    {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    // Next(limit) returns [0, limit) and Next(lo, hi) returns [lo, hi), same as Arduino's random()
+
+    uint32_t Next(uint32_t limit)
+    {
+        return (uint32_t)(((uint64_t) Next() * limit) >> 32);
+    }
+
+    uint32_t Next(uint32_t lo, uint32_t hi)
+    {
+        return lo + Next(hi - lo);
+    }
+
+    float NextFloat()
+    {
+        return (Next() >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+// FrameContext
+//
+// Everything an effect needs to know about "now".  The beat functions use the same math as
+// FastLED's beat88/beat16/beat8/beatsin16, but against the frame's timestamp instead of going
+// back to millis() for every call.
+
+struct FrameContext
+{
+    uint64_t     Micros;                // Monotonic timestamp, taken once at the start of the frame
+    uint32_t     DeltaMicros;           // Time since the previous frame started
+    uint32_t     FrameNumber;           // Zero for the first frame drawn
+    FastRandom & Random;                // Shared generator for effects that don't need their own
+    uint64_t     LocalMicros;           // This board's own clock, even when Micros is shared with others
+
+    double Seconds() const
+    {
+        return Micros / 1000000.0;
+    }
+
+    float DeltaSeconds() const
+    {
+        return DeltaMicros / 1000000.0f;
+    }
+
+    uint32_t Millis() const
+    {
+        return (uint32_t)(Micros / 1000);
+    }
+
+    uint16_t Beat88(accum88 bpm88, uint32_t timebase = 0) const
+    {
+        return ((Millis() - timebase) * bpm88 * 280) >> 16;
+    }
+
+    uint16_t Beat16(accum88 bpm, uint32_t timebase = 0) const
+    {
+        if (bpm < 256)                  // Whole-number BPMs get promoted to Q8.8, same as FastLED
+            bpm <<= 8;
+        return Beat88(bpm, timebase);
+    }
+
+    uint8_t Beat8(accum88 bpm, uint32_t timebase = 0) const
+    {
+        return Beat16(bpm, timebase) >> 8;
+    }
+
+    uint16_t BeatSin16(accum88 bpm, uint16_t lowest = 0, uint16_t highest = 65535, uint32_t timebase = 0, uint16_t phase = 0) const
+    {
+        uint16_t beatsin = sin16(Beat16(bpm, timebase) + phase) + 32768;
+        return lowest + scale16(beatsin, highest - lowest);
+    }
+};
+
+// FrameClock
+//
+// Owns the context and advances it once per pass through the main loop.  With a time source set,
+// Micros is on the shared timebase; it never runs backwards, so corrections show up as a short
+// frame rather than a repeated one.  The exception is when the source steps its timebase: holding
+// Micros until a rebooted server caught up could freeze every effect for hours, so the clock
+// follows the step, and DeltaMicros for that frame is the local time that passed.
+
+class FrameClock
+{
+  private:
+
+    FastRandom         _random;
+    FrameContext       _context;
+    const TimeSource * _pTimeSource;
+    uint32_t           _cSteps;         // The source's StepCount() as of the last frame
+
+  public:
+
+    FrameClock()
+        : _context { (uint64_t) esp_timer_get_time(), 0, (uint32_t) -1, _random, (uint64_t) esp_timer_get_time() },    // First BeginFrame wraps to frame 0
+          _pTimeSource(nullptr),
+          _cSteps(0)
+    {
+    }
+
+    void SetTimeSource(const TimeSource * pTimeSource)
+    {
+        _pTimeSource = pTimeSource;
+        _cSteps      = pTimeSource ? pTimeSource->StepCount() : 0;
+    }
+
+    const FrameContext & BeginFrame()
+    {
+        uint64_t local  = esp_timer_get_time();
+        uint32_t cSteps = _pTimeSource ? _pTimeSource->StepCount() : 0;     // Before the time, so a step in between shows next frame
+        uint64_t now    = _pTimeSource ? _pTimeSource->SharedMicros(local) : local;
+
+        if (cSteps != _cSteps)
+        {
+            _cSteps = cSteps;
+            _context.DeltaMicros = (uint32_t)(local - _context.LocalMicros);
+        }
+        else
+        {
+            if (now < _context.Micros)
+                now = _context.Micros;
+            _context.DeltaMicros = (uint32_t)(now - _context.Micros);
+        }
+        _context.Micros      = now;
+        _context.LocalMicros = local;
+        _context.FrameNumber++;
+        return _context;
+    }
+
+    const FrameContext & Current() const
+    {
+        return _context;
+    }
+};
@@ -0,0 +1,449 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        framereceiver.h
+//
+// Description:
+//
+//   Receives frames streamed over UDP from a show server and presents each
+//   one at its timestamp.  Uses only BSD sockets, so the same code builds on
+//   the ESP32 (lwIP) and on a Linux host for testing against a local sender.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <lwip/sockets.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <time.h>
+
+#ifndef HOST_ESP_TIMER                  // Shared with the other portable network headers
+#define HOST_ESP_TIMER
+inline int64_t esp_timer_get_time()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+#endif
+
+// StreamHeader
+//
+// Starts every datagram, little-endian.  A frame can be split across several datagrams that share
+// a sequence number, each carrying LEDCount pixels of RGB starting at FirstLED; it's complete
+// once every LED has arrived.  PresentationMicros is on the sender's clock.
+
+#pragma pack(push, 1)
+struct StreamHeader
+{
+    static const uint32_t MagicValue = 0x3146444E;      // "NDF1"
+
+    uint32_t Magic;
+    uint32_t Sequence;
+    uint64_t PresentationMicros;
+    uint16_t FirstLED;
+    uint16_t LEDCount;
+};
+#pragma pack(pop)
+
+// FrameReceiver
+//
+// Datagrams are read with recvmsg() straight into a jitter buffer slot - header into the slot's
+// header, pixels into the slot's frame at the right offset - so there's no intermediate packet
+// buffer.  Present() is called once per frame from the render loop and copies out the newest
+// frame that's due.  That one copy stays: a frame has to wait in its slot until its presentation
+// time while the framebuffer is still being drawn and sent, so it can't be received in place.
+//
+// The sender's clock is mapped onto ours using the smallest transit time seen (arrival minus
+// timestamp), which leaks upward slowly so clock drift gets tracked, plus a fixed playout delay
+// that covers network jitter.
+//
+// Each slot is owned by one side at a time: the receive task moves it Free -> Receiving -> Ready,
+// and the render loop moves it Ready -> Free after copying it out.
+
+class FrameReceiver
+{
+  public:
+
+    static const uint16_t DefaultPort = 49152;
+
+  private:
+
+    enum SlotState : uint32_t { SlotFree, SlotReceiving, SlotReady };
+
+    struct Slot
+    {
+        uint32_t     State;
+        StreamHeader Header;                // Header of the most recent datagram for this frame
+        uint32_t     Sequence;
+        int64_t      PresentAt;             // Local time to show it
+        size_t       cReceived;             // LEDs filled in so far, each counted once
+        uint32_t   * pCovered;              // Bit per LED that has arrived
+        uint8_t    * pPixels;               // RGB, three bytes per LED
+    };
+
+    Slot    * _slots;
+    size_t    _cSlots;
+    size_t    _cLeds;
+    int       _socket;
+    uint16_t  _port;
+    int64_t   _playoutDelay;
+    int64_t   _minTransit;
+    bool      _bHaveTransit;
+    uint32_t  _lastPresented;               // Written by the render loop, read by the receive task
+    bool      _bPresentedAny;
+    int64_t   _lastArrival;                 // Written by the receive task, read by the render loop
+
+    // Counters are bumped from both the receive task and the render loop
+
+    uint32_t  _cFrames;                     // Frames presented
+    uint32_t  _cLate;                       // Arrived after a newer frame was shown, or superseded while waiting
+    uint32_t  _cDropped;                    // Malformed, or no room to hold them
+    uint32_t  _cDuplicate;                  // Datagrams for a frame we already have
+
+    static void Count(uint32_t & counter)
+    {
+        __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+    }
+
+    static uint32_t LoadState(const Slot & slot)
+    {
+        return __atomic_load_n(&slot.State, __ATOMIC_ACQUIRE);
+    }
+
+    static void StoreState(Slot & slot, uint32_t state)
+    {
+        __atomic_store_n(&slot.State, state, __ATOMIC_RELEASE);
+    }
+
+    size_t CoverageWords() const
+    {
+        return (_cLeds + 31) / 32;
+    }
+
+    void ClaimSlot(Slot & slot, uint32_t sequence)
+    {
+        slot.Sequence  = sequence;
+        slot.cReceived = 0;
+        memset(slot.pCovered, 0, CoverageWords() * sizeof(uint32_t));
+    }
+
+    // Marks LEDs [first, first + count) as arrived and returns how many of them hadn't already,
+    // so a repeated or overlapping datagram can't make a frame look complete
+
+    static size_t Cover(Slot & slot, size_t first, size_t count)
+    {
+        size_t cNew = 0;
+        for (size_t i = first; i < first + count; i++)
+        {
+            uint32_t bit = 1u << (i & 31);
+            if (!(slot.pCovered[i >> 5] & bit))
+            {
+                slot.pCovered[i >> 5] |= bit;
+                cNew++;
+            }
+        }
+        return cNew;
+    }
+
+    // True if sequence a comes after b, allowing for wrap
+
+    static bool After(uint32_t a, uint32_t b)
+    {
+        return (int32_t)(a - b) > 0;
+    }
+
+    // Find the slot already collecting this frame, or claim a free one for it
+
+    Slot * SlotForSequence(uint32_t sequence, bool & bDuplicate)
+    {
+        Slot * pFree = nullptr;
+        bDuplicate = false;
+
+        for (size_t i = 0; i < _cSlots; i++)
+        {
+            uint32_t state = LoadState(_slots[i]);
+            if (state == SlotFree)
+            {
+                if (!pFree)
+                    pFree = &_slots[i];
+            }
+            else if (_slots[i].Sequence == sequence)
+            {
+                if (state == SlotReceiving)
+                    return &_slots[i];
+                bDuplicate = true;
+                return nullptr;
+            }
+        }
+
+        if (pFree)
+        {
+            ClaimSlot(*pFree, sequence);
+            StoreState(*pFree, SlotReceiving);
+            return pFree;
+        }
+
+        // Nothing free, so give up on the oldest frame that's still only partly here
+
+        Slot * pOldest = nullptr;
+        for (size_t i = 0; i < _cSlots; i++)
+            if (LoadState(_slots[i]) == SlotReceiving && (!pOldest || After(pOldest->Sequence, _slots[i].Sequence)))
+                pOldest = &_slots[i];
+
+        if (pOldest && After(sequence, pOldest->Sequence))
+        {
+            Count(_cDropped);
+            ClaimSlot(*pOldest, sequence);
+            return pOldest;
+        }
+        return nullptr;
+    }
+
+    // Receive one datagram; returns false on timeout or error
+
+    bool ReceiveOne()
+    {
+        StreamHeader header;
+        ssize_t cb = recv(_socket, &header, sizeof(header), MSG_PEEK);
+        if (cb < 0)
+            return false;
+
+        bool bDuplicate = false;
+        Slot * pSlot = nullptr;
+
+        if (cb == sizeof(header) && header.Magic == StreamHeader::MagicValue && (size_t) header.FirstLED + header.LEDCount <= _cLeds)
+        {
+            bool     bPresentedAny = __atomic_load_n(&_bPresentedAny, __ATOMIC_ACQUIRE);
+            uint32_t lastPresented = __atomic_load_n(&_lastPresented, __ATOMIC_RELAXED);
+            if (bPresentedAny && !After(header.Sequence, lastPresented))
+            {
+                if (header.Sequence == lastPresented)
+                    Count(_cDuplicate);
+                else
+                    Count(_cLate);
+            }
+            else
+            {
+                pSlot = SlotForSequence(header.Sequence, bDuplicate);
+                if (bDuplicate)
+                    Count(_cDuplicate);
+                else if (!pSlot)
+                    Count(_cDropped);
+            }
+        }
+        else
+        {
+            Count(_cDropped);
+        }
+
+        if (!pSlot)
+        {
+            recv(_socket, &header, sizeof(header), 0);              // Datagram sockets discard the rest
+            return true;
+        }
+
+        iovec iov[2];
+        iov[0].iov_base = &pSlot->Header;
+        iov[0].iov_len  = sizeof(StreamHeader);
+        iov[1].iov_base = pSlot->pPixels + header.FirstLED * 3;
+        iov[1].iov_len  = header.LEDCount * 3;
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = 2;
+
+        cb = recvmsg(_socket, &msg, 0);
+        if (cb != (ssize_t)(sizeof(StreamHeader) + header.LEDCount * 3))
+        {
+            Count(_cDropped);
+            StoreState(*pSlot, SlotFree);
+            return true;
+        }
+
+        // Map the sender's timestamp onto our clock
+
+        int64_t now     = esp_timer_get_time();
+        int64_t transit = now - (int64_t) header.PresentationMicros;
+        if (!_bHaveTransit || transit < _minTransit)
+            _minTransit = transit;
+        _bHaveTransit = true;
+        __atomic_store_n(&_lastArrival, now, __ATOMIC_RELAXED);
+
+        size_t cNew = Cover(*pSlot, header.FirstLED, header.LEDCount);
+        if (!cNew)
+            Count(_cDuplicate);
+        pSlot->cReceived += cNew;
+        if (pSlot->cReceived == _cLeds)
+        {
+            pSlot->PresentAt = (int64_t) header.PresentationMicros + _minTransit + _playoutDelay;
+            StoreState(*pSlot, SlotReady);
+            _minTransit += 10;                                      // Leak upward once per frame, ~600uS/sec at 60 FPS
+        }
+        return true;
+    }
+
+#ifdef ARDUINO
+    static void ReceiveTaskEntry(void * pv)
+    {
+        FrameReceiver * pThis = (FrameReceiver *) pv;
+        for (;;)
+            pThis->ReceiveOne();
+    }
+#endif
+
+  public:
+
+    FrameReceiver(size_t cLeds, size_t cSlots = 4, uint32_t playoutDelayMillis = 40)
+        : _cSlots(cSlots),
+          _cLeds(cLeds),
+          _socket(-1),
+          _port(DefaultPort),
+          _playoutDelay(playoutDelayMillis * 1000),
+          _minTransit(0),
+          _bHaveTransit(false),
+          _lastPresented(0),
+          _bPresentedAny(false),
+          _lastArrival(0),
+          _cFrames(0),
+          _cLate(0),
+          _cDropped(0),
+          _cDuplicate(0)
+    {
+        _slots = new Slot[cSlots];
+        for (size_t i = 0; i < cSlots; i++)
+        {
+            _slots[i].State    = SlotFree;
+            _slots[i].pCovered = new uint32_t[CoverageWords()];
+            _slots[i].pPixels  = new uint8_t[cLeds * 3];
+        }
+    }
+
+    virtual ~FrameReceiver()
+    {
+        if (_socket >= 0)
+            close(_socket);
+        for (size_t i = 0; i < _cSlots; i++)
+        {
+            delete [] _slots[i].pCovered;
+            delete [] _slots[i].pPixels;
+        }
+        delete [] _slots;
+    }
+
+    // Open
+    //
+    // Binds the UDP port.  Reads time out every 100ms so a host caller can poll for shutdown.
+
+    bool Open(uint16_t port = DefaultPort)
+    {
+        _port   = port;
+        _socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (_socket < 0)
+            return false;
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(_socket, (sockaddr *) &addr, sizeof(addr)) < 0)
+        {
+            close(_socket);
+            _socket = -1;
+            return false;
+        }
+
+        timeval timeout = { 0, 100000 };
+        setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return true;
+    }
+
+#ifdef ARDUINO
+    // Start
+    //
+    // Opens the port and receives on a task of its own.  Keep it off the LED output core.
+
+    bool Start(uint16_t port = DefaultPort, int core = 0, UBaseType_t priority = 2)
+    {
+        if (!Open(port))
+            return false;
+        return xTaskCreatePinnedToCore(ReceiveTaskEntry, "Frame Receiver", 4096, this, priority, nullptr, core) == pdPASS;
+    }
+#else
+    // Poll
+    //
+    // Host builds drive the receiver from their own thread
+
+    bool Poll()
+    {
+        return ReceiveOne();
+    }
+#endif
+
+    // IsStreaming
+    //
+    // True while frames have been arriving within the last second
+
+    bool IsStreaming(int64_t now) const
+    {
+        int64_t lastArrival = __atomic_load_n(&_lastArrival, __ATOMIC_RELAXED);
+        return lastArrival && now - lastArrival < 1000000;
+    }
+
+    // Present
+    //
+    // Copies the newest frame whose time has come into pLeds (RGB, three bytes per LED) and frees
+    // its slot.  Due frames that are older than that one were never shown and count as late.
+    // Returns false, leaving pLeds alone, if nothing new is due.
+
+    bool Present(int64_t now, void * pLeds)
+    {
+        Slot * pBest = nullptr;
+        for (size_t i = 0; i < _cSlots; i++)
+        {
+            Slot & slot = _slots[i];
+            if (LoadState(slot) == SlotReady && slot.PresentAt <= now && (!pBest || After(slot.Sequence, pBest->Sequence)))
+                pBest = &slot;
+        }
+        if (!pBest)
+            return false;
+
+        for (size_t i = 0; i < _cSlots; i++)
+        {
+            Slot & slot = _slots[i];
+            if (&slot != pBest && LoadState(slot) == SlotReady && After(pBest->Sequence, slot.Sequence))
+            {
+                Count(_cLate);
+                StoreState(slot, SlotFree);
+            }
+        }
+
+        memcpy(pLeds, pBest->pPixels, _cLeds * 3);
+        __atomic_store_n(&_lastPresented, pBest->Sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&_bPresentedAny, true, __ATOMIC_RELEASE);
+        Count(_cFrames);
+        StoreState(*pBest, SlotFree);
+        return true;
+    }
+
+    uint32_t PresentedFrames() const { return _cFrames; }
+    uint32_t LateFrames() const      { return _cLate; }
+    uint32_t DroppedFrames() const   { return _cDropped; }
+    uint32_t DuplicateFrames() const { return _cDuplicate; }
+};
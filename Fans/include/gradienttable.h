@@ -0,0 +1,100 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        gradienttable.h
+//
+// Description:
+//
+//   Expands a gradient palette into its 256-entry table at compile time, so
+//   the table lives in flash instead of being built into RAM the first time
+//   an effect uses it.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+// Gradients use the same layout as DEFINE_GRADIENT_PALETTE: four bytes per entry (position, r,
+// g, b), positions ascending from 0 to 255.  The expansion reproduces FastLED's CRGBPalette256
+// conversion (fill_gradient_RGB over each segment, in 8.7 fixed point) value for value, so a
+// table looks up exactly what ColorFromPalette would have returned.  It's written as C++11
+// constexpr - one expression per function - so it builds with the default toolchain flags.
+
+struct PaletteEntry
+{
+    uint8_t r, g, b;
+};
+
+struct GradientTable
+{
+    PaletteEntry Entries[256];
+};
+
+template<size_t... I> struct IndexList {};
+template<size_t N, size_t... I> struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template<size_t... I> struct MakeIndexList<0, I...> { typedef IndexList<I...> Type; };
+
+// Segment k runs from entry k to entry k + 1.  FastLED fills the segments in order, so where two
+// share an endpoint the later one wins, and it stops once a segment starts at 255.
+
+constexpr int GradientSegment(const uint8_t * pGradient, int cEntries, int i, int k = 0)
+{
+    return (k + 2 < cEntries && pGradient[(k + 1) * 4] <= i && pGradient[(k + 1) * 4] < 255)
+         ? GradientSegment(pGradient, cEntries, i, k + 1)
+         : k;
+}
+
+// One channel at index i within a segment: start value in 8.8, plus (i - start) steps of the
+// 8.7 delta doubled, wrapping at 16 bits just as FastLED's accum88 does
+
+constexpr int GradientDelta(int from, int to, int distance)
+{
+    return (to - from) * 128 / (distance ? distance : 1) * 2;
+}
+
+constexpr uint8_t GradientChannel(const uint8_t * pSegment, int c, int i)
+{
+    return (uint8_t)((((pSegment[c] * 256) + (i - pSegment[0]) * GradientDelta(pSegment[c], pSegment[4 + c], pSegment[4] - pSegment[0])) & 0xFFFF) >> 8);
+}
+
+constexpr PaletteEntry GradientEntry(const uint8_t * pSegment, int i)
+{
+    return PaletteEntry { GradientChannel(pSegment, 1, i), GradientChannel(pSegment, 2, i), GradientChannel(pSegment, 3, i) };
+}
+
+template<size_t... I>
+constexpr GradientTable ExpandGradient(const uint8_t * pGradient, int cEntries, IndexList<I...>)
+{
+    return GradientTable { { GradientEntry(pGradient + GradientSegment(pGradient, cEntries, I) * 4, I)... } };
+}
+
+// ExpandGradient
+//
+//     constexpr uint8_t gpExample[] = { 0, 0, 0, 0,   255, 255, 0, 0 };
+//     constexpr GradientTable ExampleTable = ExpandGradient(gpExample);
+
+template<size_t N>
+constexpr GradientTable ExpandGradient(const uint8_t (&gradient)[N])
+{
+    return ExpandGradient(gradient, N / 4, typename MakeIndexList<256>::Type());
+}
+
+// PaletteColor
+//
+// Reads a table entry straight out of flash.  Same result as ColorFromPalette on a CRGBPalette256
+// at full brightness with no blending.
+
+inline CRGB PaletteColor(const GradientTable & table, uint8_t index)
+{
+    const PaletteEntry & entry = table.Entries[index];
+    return CRGB(entry.r, entry.g, entry.b);
+}
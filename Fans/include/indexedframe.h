@@ -0,0 +1,144 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        indexedframe.h
+//
+// Description:
+//
+//   A framebuffer of one-byte palette indices, turned into colors only when
+//   LEDOutput sends the frame.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+#include "gradienttable.h"
+#include "palettemap.h"
+
+// IndexedFrame
+//
+// For effects whose image is really an index into a palette.  They draw indices once, a third of
+// the memory of the same image in CRGB, and from then on animate by rotating the palette: every
+// index is offset by the rotation when the frame is resolved, so a scroll or color cycle costs one
+// byte of state per frame instead of a redraw.  LEDOutput::Show resolves the indices into the
+// framebuffer as part of its pass over the frame, so no colors are worked out before then.
+//
+// The palette pointer is kept, not copied.  A PaletteFader's entries move every Update(), so hand
+// them over again each frame.
+
+class IndexedFrame
+{
+  private:
+
+    uint8_t            * _pIndices;
+    size_t               _cLeds;
+    const PaletteEntry * _pPalette;
+    uint8_t              _rotation;
+
+  public:
+
+    IndexedFrame(size_t cLeds, const PaletteEntry * pPalette)
+        : _cLeds(cLeds),
+          _pPalette(pPalette),
+          _rotation(0)
+    {
+        _pIndices = new uint8_t[cLeds];
+        memset(_pIndices, 0, cLeds);
+    }
+
+    IndexedFrame(size_t cLeds, const GradientTable & table)
+        : IndexedFrame(cLeds, table.Entries)
+    {
+    }
+
+    virtual ~IndexedFrame()
+    {
+        delete [] _pIndices;
+    }
+
+    uint8_t * Indices()               { return _pIndices; }
+    size_t    Count() const           { return _cLeds; }
+    uint8_t   Rotation() const        { return _rotation; }
+
+    void SetPalette(const PaletteEntry * pPalette)  { _pPalette = pPalette; }
+    void SetPalette(const GradientTable & table)    { _pPalette = table.Entries; }
+    void SetRotation(uint8_t rotation)              { _rotation = rotation; }
+    void Rotate(int steps)                          { _rotation += steps; }
+
+    void Fill(uint8_t index)
+    {
+        memset(_pIndices, index, _cLeds);
+    }
+
+    // Set
+    //
+    // One pixel, by position in the given order, the same way DrawFanPixels counts them
+
+    void Set(int iPos, uint8_t index, PixelOrder order = Sequential)
+    {
+        _pIndices[FanPixelMap(order)[iPos]] = index;
+    }
+
+    // FillRamp
+    //
+    // Pixel i gets start + i * step, in 8.8 fixed point like MapPaletteRamp
+
+    void FillRamp(uint16_t start, int16_t step, PixelOrder order = Sequential)
+    {
+        const uint16_t * pMap = FanPixelMap(order);
+        uint16_t index = start;
+        for (size_t i = 0; i < _cLeds; i++, index += step)
+            _pIndices[pMap[i]] = index >> 8;
+    }
+
+    // Resolve
+    //
+    // Writes the colors for LEDs [first, last) into pLeds
+
+    void Resolve(CRGB * pLeds, size_t first, size_t last) const
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            const PaletteEntry & entry = _pPalette[(uint8_t)(_pIndices[i] + _rotation)];
+            pLeds[i] = CRGB(entry.r, entry.g, entry.b);
+        }
+    }
+
+    void Resolve(CRGB * pLeds) const
+    {
+        Resolve(pLeds, 0, _cLeds);
+    }
+};
+
+// HueWheel
+//
+// CHSV(hue, 255, 255) for every hue, so a rainbow drawn with CHSV can be drawn as indices instead.
+// FastLED's hue-to-RGB conversion isn't something to redo as a constexpr, so this one is worked
+// out into RAM the first time it's needed.
+
+inline const PaletteEntry * HueWheel()
+{
+    static PaletteEntry wheel[256];
+    static bool         bBuilt = false;
+
+    if (!bBuilt)
+    {
+        for (int hue = 0; hue < 256; hue++)
+        {
+            CRGB color = CHSV(hue, 255, 255);
+            wheel[hue] = PaletteEntry { color.r, color.g, color.b };
+        }
+        bBuilt = true;
+    }
+    return wheel;
+}
@@ -19,6 +19,8 @@
 
 #include <sys/time.h>                   // For time-of-day
 
+#include "gradienttable.h"
+
 // Utility Macros
 
 #define ARRAYSIZE(x) (sizeof(x)/sizeof(x[0]))
@@ -58,14 +60,14 @@ void DrawPixels(float fPos, float count, CRGB color)
   // Calculate how much the first pixel will hold
   float availFirstPixel = 1.0f - (fPos - (long)(fPos));
   float amtFirstPixel = min(availFirstPixel, count);
-  float remaining = min(count, FastLED.size()-fPos);
+  float remaining = min(count, NUM_LEDS-fPos);
   int iPos = fPos;
 
   // Blend (add) in the color of the first partial pixel
 
   if (remaining > 0.0f)
   {
-    FastLED.leds()[iPos++] += ColorFraction(color, amtFirstPixel);
+    g_LEDs[iPos++] += ColorFraction(color, amtFirstPixel);
     remaining -= amtFirstPixel;
   }
 
@@ -73,7 +75,7 @@ void DrawPixels(float fPos, float count, CRGB color)
 
   while (remaining > 1.0f)
   {
-    FastLED.leds()[iPos++] += color;
+    g_LEDs[iPos++] += color;
     remaining--;
   }
 
@@ -81,11 +83,13 @@ void DrawPixels(float fPos, float count, CRGB color)
 
   if (remaining > 0.0f)
   {
-    FastLED.leds()[iPos] += ColorFraction(color, remaining);
+    g_LEDs[iPos] += ColorFraction(color, remaining);
   }
 }
 
-DEFINE_GRADIENT_PALETTE( vu_gpGreen ) 
+// Gradient palettes, expanded into flash-resident 256-entry tables by the compiler
+
+constexpr uint8_t vu_gpGreen[] =
 {
       0,     0,   4,   0,   // near black green
      64,     0, 255,   0,   // green
@@ -94,7 +98,7 @@ DEFINE_GRADIENT_PALETTE( vu_gpGreen )
     255,   255,   0,   0    // red
 };
 
-DEFINE_GRADIENT_PALETTE( vu_gpSeahawks ) 
+constexpr uint8_t vu_gpSeahawks[] =
 {
     0,       0,     0,   4,      
     64,      3,    38,  58,      
@@ -103,6 +107,9 @@ DEFINE_GRADIENT_PALETTE( vu_gpSeahawks )
    255,     54,    87, 140,      
 };
 
+constexpr GradientTable vu_GreenTable    = ExpandGradient(vu_gpGreen);
+constexpr GradientTable vu_SeahawksTable = ExpandGradient(vu_gpSeahawks);
+
 static const int FanPixelsVertical[FAN_SIZE] =
 {
   0, 1, 15, 2, 14, 3, 13, 4, 12, 5, 11, 6, 10, 7, 9, 8
@@ -163,14 +170,14 @@ void DrawFanPixels(float fPos, float count, CRGB color, PixelOrder order = Seque
   // Calculate how much the first pixel will hold
   float availFirstPixel = 1.0f - (fPos - (long)(fPos));
   float amtFirstPixel = min(availFirstPixel, count);
-  float remaining = min(count, FastLED.size()-fPos);
+  float remaining = min(count, NUM_LEDS-fPos);
   int iPos = fPos;
 
   // Blend (add) in the color of the first partial pixel
 
   if (remaining > 0.0f)
   {
-    FastLED.leds()[GetFanPixelOrder(iPos++, order)] += ColorFraction(color, amtFirstPixel);
+    g_LEDs[GetFanPixelOrder(iPos++, order)] += ColorFraction(color, amtFirstPixel);
     remaining -= amtFirstPixel;
   }
 
@@ -178,7 +185,7 @@ void DrawFanPixels(float fPos, float count, CRGB color, PixelOrder order = Seque
 
   while (remaining > 1.0f)
   {
-    FastLED.leds()[GetFanPixelOrder(iPos++, order)] += color;
+    g_LEDs[GetFanPixelOrder(iPos++, order)] += color;
     remaining--;
   }
 
@@ -186,6 +193,6 @@ void DrawFanPixels(float fPos, float count, CRGB color, PixelOrder order = Seque
 
   if (remaining > 0.0f)
   {
-    FastLED.leds()[GetFanPixelOrder(iPos, order)] += ColorFraction(color, remaining);
+    g_LEDs[GetFanPixelOrder(iPos, order)] += ColorFraction(color, remaining);
   }
 }
@@ -0,0 +1,627 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        ledoutput.h
+//
+// Description:
+//
+//   Registers the framebuffer with FastLED, either as one long chain on a
+//   single pin or split into equal segments on several pins that are
+//   transmitted at the same time, and pushes finished frames out to it,
+//   optionally from a task on its own core.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+#include "timingmodel.h"
+#include "framecontext.h"
+#include "indexedframe.h"
+
+// ParallelOutput
+//
+// ParallelOutput<5, 18, 19>::Add(leds, count) cuts the buffer into three equal segments and
+// registers one FastLED controller per pin.  On the ESP32 each controller gets its own RMT
+// channel and FastLED.show() starts them all together, so wire time is that of the longest
+// segment instead of the whole chain.  Build with FASTLED_ESP32_I2S to use I2S parallel output
+// instead of RMT.
+
+template<uint8_t... Pins> struct ParallelOutput;
+
+template<> struct ParallelOutput<>
+{
+    static const size_t Count = 0;
+
+    static void AddSegments(CRGB * pLeds, size_t cSegment, size_t cRemaining, size_t * pLengths)
+    {
+    }
+};
+
+template<uint8_t Pin, uint8_t... Rest> struct ParallelOutput<Pin, Rest...>
+{
+    static const size_t Count = 1 + sizeof...(Rest);
+
+    static void AddSegments(CRGB * pLeds, size_t cSegment, size_t cRemaining, size_t * pLengths)
+    {
+        size_t cLeds = min(cSegment, cRemaining);
+        pinMode(Pin, OUTPUT);
+        FastLED.addLeds<WS2812B, Pin, GRB>(pLeds, cLeds);
+        *pLengths = cLeds;
+        ParallelOutput<Rest...>::AddSegments(pLeds + cLeds, cSegment, cRemaining - cLeds, pLengths + 1);
+    }
+
+    // Add
+    //
+    // Returns the predicted best-case FPS for this layout from wire time alone
+
+    static float Add(CRGB * pLeds, size_t cLeds)
+    {
+        size_t lengths[Count];
+        AddSegments(pLeds, (cLeds + Count - 1) / Count, cLeds, lengths);
+        return PredictMaxFPS(lengths, Count, Count);
+    }
+};
+
+// SegmentCost
+//
+// Results from LEDOutput::BenchmarkSegments, in uS per frame of NUM_LEDS pixels
+
+struct SegmentCost
+{
+    float WholeMicros;                  // Summing the strip as one run, the way it would with no segments
+    float SegmentedMicros;              // Summing it split up by the power segments
+    float ScaleMicros;                  // Saving and scaling the pixels of segments with no controller of their own
+};
+
+// LEDOutput
+//
+// The last stage of every frame, and the only place that walks the whole framebuffer.  In that
+// one pass it sums each color channel, for the power estimate, and hashes the pixels, so that
+// FastLED.show() only runs when something changed and static scenes stop burning wire time and CPU.
+// Even an unchanged frame is resent every keep-alive interval in case a strip glitched or was
+// hot-plugged.  A hash collision can hide a real change, but only until the next keep-alive.
+//
+// An effect that drew an IndexedFrame passes it in, and its colors are resolved into the
+// framebuffer a range at a time just ahead of summing that range, so this is still the one pass.
+//
+// Power limiting happens here too instead of inside FastLED, which would walk the buffer yet
+// again.  The brightness drops immediately when a frame would go over budget, but only climbs back
+// at a limited rate, so frames that hover around the limit don't make the strip pump.
+//
+// Besides the overall limit, ranges of the strip (a fan, or a bank of fans on one supply) can be
+// given their own budgets.  Each one is summed separately during the same pass and scaled on its
+// own, so a hot fire on one fan doesn't dim the rest.  If a range is exactly one FastLED
+// controller's LEDs, as with ParallelOutput, the scaling goes into that controller's color
+// correction; otherwise the range's pixels are scaled in the buffer being sent.
+//
+// Started with an output core, frames are sent by a task pinned to that core.  FastLED sets up its
+// RMT interrupt on whichever core first calls show(), so the ISR that refills the RMT buffers
+// lives there too.  Core 1 keeps it away from WiFi, lwIP and the tasks that use them on core 0;
+// it shares core 1 with the render loop, but the output task outranks loop(), and no task can
+// hold off an ISR anyway.  Show() memcpy's each frame into whichever of two transmit buffers
+// isn't on the wire, so the render loop only waits if it gets a whole frame ahead of the strip.
+// Nothing on this path masks interrupts.
+//
+// Late frames, where show() ran well over the wire time, are counted.  A frame corrupted by an
+// RMT underrun isn't: FastLED gives no sign of one, so that has to be checked by eye.
+
+class LEDOutput
+{
+  public:
+
+    // Same per-channel draw FastLED's power manager assumes for WS2812s at 5V
+
+    static const uint32_t RedMilliwatts   = 16 * 5;
+    static const uint32_t GreenMilliwatts = 11 * 5;
+    static const uint32_t BlueMilliwatts  = 15 * 5;
+    static const uint32_t DarkMilliwatts  = 1 * 5;          // Per LED, even when it's black
+    static const uint32_t MCUMilliwatts   = 25 * 5;
+
+    static const size_t   MaxPowerSegments = 8;
+
+  private:
+
+    struct PowerSegment
+    {
+        size_t           First;
+        size_t           Count;
+        uint32_t         PowerLimit;    // Milliwatts for just this range
+        CLEDController * pController;   // Controller that owns exactly this range, if there is one
+        float            Scale;         // 0-255, applied on top of the overall brightness
+        uint32_t         Power;         // What this range drew last frame, after scaling
+    };
+
+    // Running per-channel sums and hash for part of the frame
+
+    struct FrameSums
+    {
+        uint32_t Red, Green, Blue;
+        uint32_t Hash;
+
+        void Add(const CRGB * p, const CRGB * pEnd)
+        {
+            for (; p < pEnd; p++)
+            {
+                Red   += p->r;
+                Green += p->g;
+                Blue  += p->b;
+                Hash   = (Hash ^ (p->r | (p->g << 8) | (p->b << 16))) * 0x9E3779B1;
+                Hash   = (Hash << 13) | (Hash >> 19);
+            }
+        }
+    };
+
+    uint32_t _lastHash;
+    uint64_t _lastShowMicros;
+    uint32_t _keepAliveMicros;
+    uint32_t _cShown;
+    uint32_t _cSkipped;
+    bool     _bInvalid;                 // Forces the next frame out regardless of its hash
+
+    uint32_t _powerLimit;               // Milliwatts, or 0 for no limit
+    float    _brightness;               // What we're actually showing at, after power limiting
+    float    _recoveryPerSecond;        // How fast brightness may climb back after being clamped
+    uint32_t _unscaledPower;            // Whole-strip draw at full brightness, last frame
+    uint32_t _scaledPower;              // Whole-strip draw at the brightness actually shown
+
+    PowerSegment _segments[MaxPowerSegments];
+    size_t       _cSegments;
+    uint32_t     _passMicros;           // Time spent in our pass over the frame, not counting show()
+    uint32_t     _sumMicros;            // The part of that spent walking the strip for sums and hash
+    uint32_t     _scaleMicros;          // Scaling segments in the frame, and putting them back after
+    CRGB *       _pSaved;               // Without an output task, unscaled pixels of segments scaled in g_LEDs
+
+    // Output task state.  Everything in the "queued" group is written by the render side before it
+    // gives _hFrameQueued and only read by the output task after taking it.
+
+    CRGB *            _pOutput;             // Buffer the FastLED controllers are currently sending from
+    CRGB *            _txBuffers[2];
+    int               _fillIndex;           // Which transmit buffer the next frame gets copied into
+    SemaphoreHandle_t _hFrameQueued;
+    SemaphoreHandle_t _hOutputIdle;
+    int               _queuedIndex;
+    uint8_t           _queuedBrightness;
+    uint8_t           _queuedScales[MaxPowerSegments];
+    uint32_t          _expectedShowMicros;  // Wire time we expect a frame to take, for spotting late ones
+    volatile uint32_t _lastShowDuration;
+    volatile uint32_t _cLate;
+    int64_t           _firstShowMicros;     // When the first frame finished going out, or 0 if none has yet
+
+    // Sum LEDs [first, last), resolving them from the indexed frame first if there is one
+
+    static void Sum(FrameSums & sums, size_t first, size_t last, const IndexedFrame * pIndexed)
+    {
+        if (pIndexed)
+            pIndexed->Resolve(g_LEDs, first, last);
+        sums.Add(g_LEDs + first, g_LEDs + last);
+    }
+
+    // One walk over the strip.  Each of the first cSegments budgeted segments gets summed on its own
+    // and then folded into the total; the gaps between them go straight into the total.
+
+    void SumFrame(FrameSums & total, uint32_t * pSegmentUnscaled, size_t cSegments, const IndexedFrame * pIndexed) const
+    {
+        size_t next = 0;
+        for (size_t i = 0; i < cSegments; i++)
+        {
+            const PowerSegment & segment = _segments[i];
+            Sum(total, next, segment.First, pIndexed);
+
+            FrameSums sums = { 0, 0, 0, total.Hash };
+            Sum(sums, segment.First, segment.First + segment.Count, pIndexed);
+            pSegmentUnscaled[i] = PowerFromSums(sums.Red, sums.Green, sums.Blue, segment.Count);
+
+            total.Red   += sums.Red;
+            total.Green += sums.Green;
+            total.Blue  += sums.Blue;
+            total.Hash   = sums.Hash;
+            next = segment.First + segment.Count;
+        }
+        Sum(total, next, NUM_LEDS, pIndexed);
+    }
+
+    // Unscaled draw of a run of LEDs from its per-channel sums, the same way FastLED does it
+
+    static uint32_t PowerFromSums(uint32_t red, uint32_t green, uint32_t blue, size_t cLeds)
+    {
+        return ((red * RedMilliwatts) >> 8) + ((green * GreenMilliwatts) >> 8) + ((blue * BlueMilliwatts) >> 8) + DarkMilliwatts * cLeds;
+    }
+
+    // Move a brightness or scale toward a target: down at once, up no faster than the recovery rate
+
+    float Slew(float current, float target, float dt) const
+    {
+        return target < current ? target : min(target, current + _recoveryPerSecond * dt);
+    }
+
+    // Send whatever the controllers point at, keeping track of frames the wire took too long on
+
+    void TimedShow(uint8_t brightness)
+    {
+        uint64_t start = esp_timer_get_time();
+        FastLED.show(brightness);
+        _lastShowDuration = esp_timer_get_time() - start;
+        if (!__atomic_load_n(&_firstShowMicros, __ATOMIC_RELAXED))
+            __atomic_store_n(&_firstShowMicros, (int64_t)(start + _lastShowDuration), __ATOMIC_RELEASE);
+
+        if (_expectedShowMicros && _lastShowDuration > _expectedShowMicros + _expectedShowMicros / 4)
+            _cLate++;
+    }
+
+    static void OutputTaskEntry(void * pv)
+    {
+        ((LEDOutput *) pv)->OutputTask();
+    }
+
+    void OutputTask()
+    {
+        for (;;)
+        {
+            xSemaphoreTake(_hFrameQueued, portMAX_DELAY);
+
+            // Point every controller at its slice of the buffer that was just filled
+
+            CRGB * pBuffer = _txBuffers[_queuedIndex];
+            for (int i = 0; i < FastLED.count(); i++)
+                FastLED[i].setLeds(pBuffer + (FastLED[i].leds() - _pOutput), FastLED[i].size());
+            _pOutput = pBuffer;
+
+            for (size_t i = 0; i < _cSegments; i++)
+                if (_segments[i].pController)
+                    _segments[i].pController->setCorrection(CRGB(_queuedScales[i], _queuedScales[i], _queuedScales[i]));
+
+            TimedShow(_queuedBrightness);
+            xSemaphoreGive(_hOutputIdle);
+        }
+    }
+
+  public:
+
+    LEDOutput(uint32_t keepAliveMillis = 1000)
+        : _lastHash(0),
+          _lastShowMicros(0),
+          _keepAliveMicros(keepAliveMillis * 1000),
+          _cShown(0),
+          _cSkipped(0),
+          _bInvalid(true),
+          _powerLimit(0),
+          _brightness(255),
+          _recoveryPerSecond(128),
+          _unscaledPower(0),
+          _scaledPower(0),
+          _cSegments(0),
+          _passMicros(0),
+          _sumMicros(0),
+          _scaleMicros(0),
+          _pSaved(nullptr),
+          _pOutput(g_LEDs),
+          _txBuffers { nullptr, nullptr },
+          _fillIndex(0),
+          _hFrameQueued(nullptr),
+          _hOutputIdle(nullptr),
+          _queuedIndex(0),
+          _queuedBrightness(0),
+          _expectedShowMicros(0),
+          _lastShowDuration(0),
+          _cLate(0),
+          _firstShowMicros(0)
+    {
+    }
+
+    // Begin
+    //
+    // Pass a core number to send frames from a task pinned to that core, or -1 to send them from
+    // the caller.  Returns the buffer that should be registered with FastLED.
+
+    CRGB * Begin(int outputCore = -1, UBaseType_t priority = 3)
+    {
+        if (outputCore < 0)
+            return _pOutput = g_LEDs;
+
+        _txBuffers[0] = new CRGB[NUM_LEDS];
+        _txBuffers[1] = new CRGB[NUM_LEDS];
+        memset((void *) _txBuffers[0], 0, NUM_LEDS * sizeof(CRGB));
+        memset((void *) _txBuffers[1], 0, NUM_LEDS * sizeof(CRGB));
+        _pOutput = _txBuffers[0];
+
+        _hFrameQueued = xSemaphoreCreateBinary();
+        _hOutputIdle  = xSemaphoreCreateBinary();
+        xSemaphoreGive(_hOutputIdle);
+
+        xTaskCreatePinnedToCore(OutputTaskEntry, "LED Output", 4096, this, priority, nullptr, outputCore);
+        return _pOutput;
+    }
+
+    void SetKeepAlive(uint32_t keepAliveMillis)
+    {
+        _keepAliveMicros = keepAliveMillis * 1000;
+    }
+
+    // SetExpectedShowMicros
+    //
+    // Frames whose show() takes more than 25% longer than this are counted as late
+
+    void SetExpectedShowMicros(uint32_t micros)
+    {
+        _expectedShowMicros = micros;
+    }
+
+    // SetPowerLimit
+    //
+    // Limit is for the whole installation, in milliwatts.  Recovery is in brightness steps per second.
+
+    void SetPowerLimit(uint32_t milliwatts, float recoveryPerSecond = 128)
+    {
+        _powerLimit        = milliwatts;
+        _recoveryPerSecond = recoveryPerSecond;
+    }
+
+    // AddPowerSegment
+    //
+    // Gives LEDs [first, first + count) their own budget.  Segments must be added in strip order
+    // and can't overlap.  Call after the LEDs have been registered with FastLED.
+
+    bool AddPowerSegment(size_t first, size_t count, uint32_t milliwatts)
+    {
+        if (_cSegments == MaxPowerSegments || first + count > NUM_LEDS)
+            return false;
+        if (_cSegments && first < _segments[_cSegments - 1].First + _segments[_cSegments - 1].Count)
+            return false;
+
+        PowerSegment & segment = _segments[_cSegments++];
+        segment.First       = first;
+        segment.Count       = count;
+        segment.PowerLimit  = milliwatts;
+        segment.pController = nullptr;
+        segment.Scale       = 255;
+        segment.Power       = 0;
+
+        for (int i = 0; i < FastLED.count(); i++)
+            if (FastLED[i].leds() == _pOutput + first && (size_t) FastLED[i].size() == count)
+                segment.pController = &FastLED[i];
+
+        return true;
+    }
+
+    // Invalidate
+    //
+    // Call when something outside the framebuffer changes what the strip should show
+
+    void Invalidate()
+    {
+        _bInvalid = true;
+    }
+
+    uint32_t ShownFrames() const                { return _cShown; }
+    uint32_t SkippedFrames() const              { return _cSkipped; }
+    uint32_t LateFrames() const                 { return _cLate; }
+    uint32_t ShowDurationMicros() const         { return _lastShowDuration; }
+    int64_t  FirstShowMicros() const            { return __atomic_load_n(&_firstShowMicros, __ATOMIC_ACQUIRE); }
+    uint8_t  Brightness() const                 { return _brightness; }
+    uint32_t UnscaledPowerMilliwatts() const    { return _unscaledPower; }
+    uint32_t PowerMilliwatts() const            { return _scaledPower; }
+    bool     IsThrottled(uint8_t requested) const { return (uint8_t) _brightness < requested; }
+    uint32_t PassMicros() const                 { return _passMicros; }
+    uint32_t SumMicros() const                  { return _sumMicros; }
+    uint32_t ScaleMicros() const                { return _scaleMicros; }
+    size_t   PowerSegments() const              { return _cSegments; }
+    uint32_t SegmentPowerMilliwatts(size_t i) const { return _segments[i].Power; }
+    uint8_t  SegmentScale(size_t i) const       { return _segments[i].Scale; }
+
+    // BenchmarkSegments
+    //
+    // What the power segments cost on the frame in g_LEDs: the walk with and without them, and
+    // scaling every segment that has no controller of its own as if it were over budget.  Works
+    // on a copy, so the frame and the slewed scales are left alone.
+
+    SegmentCost BenchmarkSegments(int cFrames = 100) const
+    {
+        SegmentCost cost = { 0.0f, 0.0f, 0.0f };
+        uint32_t    segmentUnscaled[MaxPowerSegments];
+        CRGB *      pScratch = new CRGB[NUM_LEDS];
+        CRGB *      pSaved   = new CRGB[NUM_LEDS];
+        volatile uint32_t hash = 0;     // Somewhere for the sums to go so they aren't optimized away
+
+        uint64_t start = esp_timer_get_time();
+        for (int i = 0; i < cFrames; i++)
+        {
+            FrameSums total = { 0, 0, 0, 0x811C9DC5 };
+            SumFrame(total, segmentUnscaled, 0, nullptr);
+            hash = hash ^ total.Hash;
+        }
+        cost.WholeMicros = (float)(esp_timer_get_time() - start) / cFrames;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < cFrames; i++)
+        {
+            FrameSums total = { 0, 0, 0, 0x811C9DC5 };
+            SumFrame(total, segmentUnscaled, _cSegments, nullptr);
+            hash = hash ^ total.Hash;
+        }
+        cost.SegmentedMicros = (float)(esp_timer_get_time() - start) / cFrames;
+
+        memcpy((void *) pScratch, (const void *) g_LEDs, NUM_LEDS * sizeof(CRGB));
+        start = esp_timer_get_time();
+        for (int i = 0; i < cFrames; i++)
+            for (size_t j = 0; j < _cSegments; j++)
+            {
+                const PowerSegment & segment = _segments[j];
+                if (segment.pController)
+                    continue;
+                memcpy((void *)(pSaved + segment.First), (const void *)(pScratch + segment.First), segment.Count * sizeof(CRGB));
+                for (CRGB * p = pScratch + segment.First; p < pScratch + segment.First + segment.Count; p++)
+                    p->nscale8_video(192);
+                memcpy((void *)(pScratch + segment.First), (const void *)(pSaved + segment.First), segment.Count * sizeof(CRGB));
+            }
+        cost.ScaleMicros = (float)(esp_timer_get_time() - start) / cFrames;
+
+        delete [] pScratch;
+        delete [] pSaved;
+        return cost;
+    }
+
+    // Show
+    //
+    // Returns true if the frame was actually sent (or queued to be sent) to the strip.  Pass the
+    // indexed frame if the effect drew one; it replaces whatever is in g_LEDs.
+
+    bool Show(const FrameContext & frame, uint8_t requestedBrightness, const IndexedFrame * pIndexed = nullptr)
+    {
+        uint64_t  start = esp_timer_get_time();
+        float     dt    = frame.DeltaSeconds();
+        FrameSums total = { 0, 0, 0, 0x811C9DC5 };
+        uint32_t  segmentUnscaled[MaxPowerSegments];
+        uint8_t   scales[MaxPowerSegments];
+
+        SumFrame(total, segmentUnscaled, _cSegments, pIndexed);
+        _sumMicros = esp_timer_get_time() - start;
+
+        // Work out the most brightness the overall budget allows for this frame, then slew toward it
+
+        _unscaledPower = PowerFromSums(total.Red, total.Green, total.Blue, NUM_LEDS);
+
+        float allowed = requestedBrightness;
+        if (_powerLimit)
+        {
+            uint32_t requestedPower = (_unscaledPower * requestedBrightness) / 256 + MCUMilliwatts;
+            if (requestedPower > _powerLimit)
+                allowed = _powerLimit > MCUMilliwatts ? (_powerLimit - MCUMilliwatts) * 256.0f / _unscaledPower : 0.0f;
+        }
+        _brightness = Slew(_brightness, allowed, dt);
+
+        uint8_t  brightness = _brightness;
+        uint32_t hash       = (total.Hash ^ brightness) * 0x01000193;
+
+        // Then let each segment pull itself down further if its own supply can't keep up
+
+        _scaledPower = (_unscaledPower * brightness) / 256 + MCUMilliwatts;
+        for (size_t i = 0; i < _cSegments; i++)
+        {
+            PowerSegment & segment = _segments[i];
+            uint32_t power  = (segmentUnscaled[i] * brightness) / 256;
+            float    target = power > segment.PowerLimit ? 255.0f * segment.PowerLimit / power : 255.0f;
+
+            segment.Scale = Slew(segment.Scale, target, dt);
+            scales[i]     = segment.Scale;
+            segment.Power = (power * scales[i]) / 256;
+            _scaledPower -= power - segment.Power;
+            hash = (hash ^ scales[i]) * 0x01000193;
+        }
+
+        _passMicros = esp_timer_get_time() - start;
+
+        if (!_bInvalid && hash == _lastHash && frame.Micros - _lastShowMicros < _keepAliveMicros)
+        {
+            _cSkipped++;
+            return false;
+        }
+        _lastHash       = hash;
+        _lastShowMicros = frame.Micros;
+        _bInvalid       = false;
+        _cShown++;
+
+        // With an output task, copy the frame into the idle transmit buffer while the other one may
+        // still be going out, then hand it over once the task is free
+
+        CRGB * pTarget = g_LEDs;
+        if (_hFrameQueued)
+        {
+            pTarget = _txBuffers[_fillIndex];
+            memcpy((void *) pTarget, (const void *) g_LEDs, NUM_LEDS * sizeof(CRGB));
+        }
+
+        // Without an output task, a segment with no controller of its own is scaled in g_LEDs
+        // itself, so its pixels are put back after the show.  Otherwise a frame that isn't redrawn
+        // would be scaled again every time it was sent and fade away.
+
+        uint64_t scaleStart = esp_timer_get_time();
+        bool     bRestore   = false;
+        for (size_t i = 0; i < _cSegments; i++)
+        {
+            PowerSegment & segment = _segments[i];
+            if (segment.pController)
+            {
+                if (!_hFrameQueued)
+                    segment.pController->setCorrection(CRGB(scales[i], scales[i], scales[i]));
+            }
+            else if (scales[i] < 255)
+            {
+                if (!_hFrameQueued)
+                {
+                    if (!_pSaved)
+                        _pSaved = new CRGB[NUM_LEDS];
+                    memcpy((void *)(_pSaved + segment.First), (const void *)(pTarget + segment.First), segment.Count * sizeof(CRGB));
+                    bRestore = true;
+                }
+                for (CRGB * p = pTarget + segment.First; p < pTarget + segment.First + segment.Count; p++)
+                    p->nscale8_video(scales[i]);
+            }
+        }
+        _scaleMicros = esp_timer_get_time() - scaleStart;
+
+        if (!_hFrameQueued)
+        {
+            TimedShow(brightness);                                  // Returns once the strip has been sent
+            if (bRestore)
+            {
+                uint64_t restoreStart = esp_timer_get_time();
+                for (size_t i = 0; i < _cSegments; i++)
+                    if (!_segments[i].pController && scales[i] < 255)
+                        memcpy((void *)(g_LEDs + _segments[i].First), (const void *)(_pSaved + _segments[i].First), _segments[i].Count * sizeof(CRGB));
+                _scaleMicros += esp_timer_get_time() - restoreStart;
+            }
+            return true;
+        }
+
+        xSemaphoreTake(_hOutputIdle, portMAX_DELAY);
+        _queuedIndex      = _fillIndex;
+        _queuedBrightness = brightness;
+        memcpy(_queuedScales, scales, sizeof(scales));
+        xSemaphoreGive(_hFrameQueued);
+
+        _fillIndex ^= 1;
+        return true;
+    }
+};
+
+// StartOutputStressLoad
+//
+// For checking output under load: fires a hardware timer interrupt every periodMicros on the given
+// core and spins inside it for busyMicros, the way a busy WiFi or I2C driver might.  Point it at
+// the output core and watch LEDOutput::LateFrames() and the strip itself while it runs.
+
+static volatile uint32_t g_StressBusyMicros = 0;
+
+void IRAM_ATTR OutputStressISR()
+{
+    int64_t until = esp_timer_get_time() + g_StressBusyMicros;
+    while (esp_timer_get_time() < until)
+        ;
+}
+
+static uint32_t g_StressPeriodMicros = 0;
+
+// Interrupts are allocated on the core that attaches them, so this runs there once and goes away
+
+static void StressSetupTask(void *)
+{
+    hw_timer_t * pTimer = timerBegin(0, 80, true);              // 80MHz APB clock / 80 = 1uS ticks
+    timerAttachInterrupt(pTimer, &OutputStressISR, true);
+    timerAlarmWrite(pTimer, g_StressPeriodMicros, true);
+    timerAlarmEnable(pTimer);
+    vTaskDelete(nullptr);
+}
+
+void StartOutputStressLoad(int core, uint32_t periodMicros, uint32_t busyMicros)
+{
+    g_StressBusyMicros   = busyMicros;
+    g_StressPeriodMicros = periodMicros;
+    xTaskCreatePinnedToCore(StressSetupTask, "Stress Setup", 2048, nullptr, 1, nullptr, core);
+}
@@ -9,6 +9,7 @@
 //   Draws a theatre-style marquee
 //
 // History:     Sep-15-2020     davepl      Created
+//              Oct-19-2026     davepl      MarqueeEffect scrolls a prebuilt ring
 //
 //---------------------------------------------------------------------------
 
@@ -17,57 +18,101 @@
 #define FASTLED_INTERNAL
 #include <FastLED.h>
 
+#include "framecontext.h"
 
-void DrawMarquee()
+// MarqueeEffect
+//
+// A rainbow that advances 8 hue steps per pixel (so it repeats every 32 pixels) with every fifth
+// pixel blanked.  The whole pattern repeats every 160 pixels, so it's built once into a ring and
+// scrolled by moving an offset; each frame is then just a copy out of the ring, or a single blend
+// pass when the offset lands between pixels.
+
+class MarqueeEffect
 {
-    static byte j = 0;
-    j+=4;
-    byte k = j;
+  public:
 
-    // Roughly equivalent to fill_rainbow(g_LEDs, NUM_LEDS, j, 8);
+    static const int HueStep    = 8;
+    static const int MaskPeriod = 5;
+    static const int RingSize   = (256 / HueStep) * MaskPeriod;
 
-    CRGB c;
-    for (int i = 0; i < FastLED.count(); i ++)
-        FastLED.leds()[i] = c.setHue(k+=8);
+  private:
 
-    static int scroll = 0;
-    scroll++;
+    CRGB  _ring[RingSize];
+    float _offset;                      // Pixels scrolled as of this frame, within [0, RingSize)
+    float _speed;                       // Pixels per second
 
-    for (int i = scroll % 5; i < FastLED.count() - 1; i += 5)
+    // Copy (or blend) cLeds pixels of the ring, scrolled by the current offset, into pLeds
+
+    void Fill(CRGB * pLeds, int cLeds) const
     {
-        FastLED.leds()[i] = CRGB::Black;
+        int  whole = (int) _offset;
+        byte frac  = (_offset - whole) * 256;
+        int  start = (RingSize - whole) % RingSize;
+
+        if (frac == 0)
+        {
+            for (int i = 0; i < cLeds; )
+            {
+                int run = min(RingSize - start, cLeds - i);
+                memcpy(pLeds + i, _ring + start, run * sizeof(CRGB));
+                i += run;
+                start = 0;
+            }
+        }
+        else
+        {
+            int prev = (start + RingSize - 1) % RingSize;
+            for (int i = 0; i < cLeds; i++)
+            {
+                pLeds[i] = blend(_ring[start], _ring[prev], frac);
+                prev  = start;
+                start = start + 1 == RingSize ? 0 : start + 1;
+            }
+        }
     }
-    delay(50);
-}
 
-void DrawMarqueeMirrored()
-{
-    static byte j = 0;
-    j+=4;
-    byte k = j;
-
-    // Roughly equivalent to fill_rainbow(g_LEDs, NUM_LEDS, j, 8);
+  public:
 
-    CRGB c;
-    for (int i = 0; i < (FastLED.count() + 1) / 2; i ++)
+    MarqueeEffect(float pixelsPerSecond = 20.0f, byte startHue = 0)
+        : _offset(0),
+          _speed(pixelsPerSecond)
     {
-        FastLED.leds()[i] = c.setHue(k);
-        FastLED.leds()[FastLED.count() - 1 - i] = c.setHue(k);
-        k+= 8;
+        byte hue = startHue;
+        for (int i = 0; i < RingSize; i++, hue += HueStep)
+            _ring[i] = (i % MaskPeriod == 0) ? CRGB(CRGB::Black) : CRGB(CHSV(hue, 255, 255));
     }
 
+    // The offset comes straight from the frame time rather than being accumulated, so boards on a
+    // shared clock scroll in step whenever each of them booted
 
-    static int scroll = 0;
-    scroll++;
-
-    for (int i = scroll % 5; i < FastLED.count() / 2; i += 5)
+    void Draw(const FrameContext & frame, bool bMirrored = false)
     {
-        FastLED.leds()[i] = CRGB::Black;
-        FastLED.leds()[FastLED.count() - 1 - i] = CRGB::Black;
-    }   
+        _offset = fmod((double) _speed * frame.Micros / 1000000.0, (double) RingSize);
 
-    delay(50);
-}
+        CRGB * pLeds = g_LEDs;
+        int    cLeds = NUM_LEDS;
 
+        if (!bMirrored)
+        {
+            Fill(pLeds, cLeds);
+            return;
+        }
 
+        int half = (cLeds + 1) / 2;
+        Fill(pLeds, half);
+        for (int i = 0; i < cLeds / 2; i++)
+            pLeds[cLeds - 1 - i] = pLeds[i];
+    }
+};
 
+void DrawMarquee(const FrameContext & frame)
+{
+    static MarqueeEffect marquee;
+    marquee.Draw(frame);
+}
+
+void DrawMarqueeMirrored(const FrameContext & frame)
+{
+    static MarqueeEffect marquee;
+    marquee.Draw(frame, true);
+}
@@ -0,0 +1,422 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        oleddash.h
+//
+// Description:
+//
+//   Status dashboard for the 128x64 OLED: two lines of text, a preview of the
+//   frame on the LEDs, and sparklines of where each frame's time went.  Only
+//   the 8x8 tiles that changed are sent, a few at a time.  Works with U8g2's
+//   full frame buffer or either page buffer.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+#include <esp_timer.h>
+
+// OLEDDashboard
+//
+//   y  0-15    Status line from the caller, then average render/show/idle times
+//   y 16-31    The LEDs as a bar graph of brightness, downsampled or stretched to 128 columns
+//   y 32-63    Sparklines of render, show and idle time per frame, newest on the right
+//
+// The dashboard remembers every 8x8 tile the panel holds and sends only the tiles that differ, in
+// runs along a tile row so each run is one transfer.
+//
+// With U8g2's full frame buffer, a picture is drawn once and its changed tiles go out at most a
+// fixed number per Update(); the next picture is drawn once they've all gone.  The I2C cost of a
+// frame is capped no matter how much of the screen is moving, and a static screen costs nothing.
+//
+// With a page buffer (the _1 and _2 constructors, 128 or 256 bytes instead of 1K) there's only room
+// for one band of tile rows at a time, so each Update() draws the whole picture clipped to the next
+// band and sends that band's changes before moving on.  That trades RAM for CPU: the picture is
+// drawn once per band instead of once, and the cap per Update() is the band rather than a tile
+// count.  So that every band of a picture draws the same sparklines, the sample ring has room for
+// a band's worth of samples past the ones on screen, and a picture draws from the window that was
+// newest when it started.  The status text and LED preview are whatever each band was given.
+//
+// With the full frame buffer the dashboard keeps an exact 1K copy of the panel, so nothing is ever
+// missed.  A page buffer is used to save RAM, so there it keeps only a 16-bit hash per tile, and a
+// hash collision can leave a stale tile on the panel until that tile changes again.
+
+class OLEDDashboard
+{
+  public:
+
+    static const int    Samples             = 120;
+    static const size_t DefaultTilesPerCall = 8;            // 64 bytes of I2C, about 1.5ms at 400kHz
+
+  private:
+
+    enum Trace { Render, Show, Idle, Traces };
+
+    static const int MaxTileColumns = 16;
+    static const int MaxTileRows    = 8;
+
+    U8G2 &     _oled;
+    size_t     _tilesPerCall;
+    uint8_t  * _pShadow;                // Full buffer only: exact copy of every tile the panel holds
+    uint16_t   _tileHash[MaxTileRows][MaxTileColumns];  // Page buffer only: hash of what the panel holds
+    uint16_t   _dirty[MaxTileRows];     // Bit per tile column for each tile row still to send
+    int        _cDirty;
+    bool       _bInvalid;               // Resend every tile of the next picture
+    int        _bandRow;                // Page buffer only: tile row the next band starts at
+
+    static const int RingSize = Samples + MaxTileRows;     // A picture takes at most one band per sample
+
+    uint16_t   _samples[Traces][RingSize];  // uS, clamped to 65535
+    int        _next;                   // Where the next sample goes
+    int        _cSamples;               // Up to Samples
+    int        _pictureNext;            // _next and _cSamples as they were when this picture started
+    int        _pictureSamples;
+
+    uint32_t   _cTilesSent;
+    uint32_t   _cPictures;
+    uint32_t   _worstMicros;            // Longest single Update()
+    uint32_t   _pictureMicros;          // Running total for the picture in progress
+    uint32_t   _refreshMicros;          // Total for the last complete picture, drawing and sending
+
+    int  TileColumns()  { return min(_oled.getBufferTileWidth(), MaxTileColumns); }
+    int  BandRows()     { return _oled.getBufferTileHeight(); }
+    bool IsPaged()      { return BandRows() < MaxTileRows; }
+
+    // The i'th oldest of the samples the current picture shows
+
+    uint16_t PictureSample(Trace trace, int i) const
+    {
+        return _samples[trace][(_pictureNext - _pictureSamples + i + RingSize) % RingSize];
+    }
+
+    // Every bit of the tile moves every bit of the hash (MurmurHash3's 64-bit finalizer), so sparse
+    // tiles that differ by a pixel or two don't land on the same value any more often than chance
+
+    static uint16_t TileHash(const uint8_t * p)
+    {
+        uint64_t x;
+        memcpy(&x, p, sizeof(x));
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        x ^= x >> 33;
+        return (uint16_t)(x >> 48);
+    }
+
+    uint8_t * ShadowTile(int row, int col)
+    {
+        return _pShadow + (row * MaxTileColumns + col) * 8;
+    }
+
+    bool TileDiffers(int row, int col, const uint8_t * pTile)
+    {
+        if (_pShadow)
+            return memcmp(ShadowTile(row, col), pTile, 8) != 0;
+        return TileHash(pTile) != _tileHash[row][col];
+    }
+
+    void TileSent(int row, int col, const uint8_t * pTile)
+    {
+        if (_pShadow)
+            memcpy(ShadowTile(row, col), pTile, 8);
+        else
+            _tileHash[row][col] = TileHash(pTile);
+    }
+
+    void DrawText(const char * status)
+    {
+        uint32_t sums[Traces] = { 0, 0, 0 };
+        for (int t = 0; t < Traces; t++)
+            for (int i = 0; i < _pictureSamples; i++)
+                sums[t] += PictureSample((Trace) t, i);
+        int n = _pictureSamples ? _pictureSamples : 1;
+
+        char line[32];
+        snprintf(line, sizeof(line), "R%.1f S%.1f I%.1f ms", sums[Render] / 1000.0f / n, sums[Show] / 1000.0f / n, sums[Idle] / 1000.0f / n);
+
+        _oled.setFont(u8g2_font_5x7_tf);
+        _oled.drawStr(0, 7, status);
+        _oled.drawStr(0, 15, line);
+    }
+
+    // One column per slice of the strip, as tall as the brightest channel of its first LED.  With
+    // fewer LEDs than columns, the last column of each LED is left blank so they read separately.
+
+    void DrawPreview(const CRGB * pLeds, size_t cLeds)
+    {
+        const int Width = 128, Top = 16, Height = 16;
+        if (!cLeds)
+            return;
+
+        uint32_t step = ((uint32_t) cLeds << 16) / Width;   // LEDs per column, 16.16
+        uint32_t pos  = 0;
+        for (int x = 0; x < Width; x++, pos += step)
+        {
+            size_t i = pos >> 16;
+            if (cLeds < Width && ((pos + step) >> 16) != i)
+                continue;
+            const CRGB & c = pLeds[i];
+            uint8_t level = max(c.r, max(c.g, c.b));
+            int h = (level * Height + 255) >> 8;
+            if (h)
+                _oled.drawVLine(x, Top + Height - h, h);
+        }
+    }
+
+    // Each trace gets its own 10-pixel band, scaled to its largest sample rounded up to a whole ms
+
+    void DrawSparkline(Trace trace, int top, char label)
+    {
+        const int Left = 8, Height = 10;
+
+        char text[2] = { label, 0 };
+        _oled.setFont(u8g2_font_4x6_tf);
+        _oled.drawStr(0, top + 7, text);
+
+        if (_pictureSamples < 2)
+            return;
+
+        uint32_t scale = 1000;
+        for (int i = 0; i < _pictureSamples; i++)
+            while (PictureSample(trace, i) > scale)
+                scale += 1000;
+
+        int prevY = -1;
+        for (int i = 0; i < _pictureSamples; i++)
+        {
+            uint16_t value = PictureSample(trace, i);
+            int y = top + Height - 1 - (int)(value * (Height - 1) / scale);
+            int x = Left + Samples - _pictureSamples + i;
+            if (prevY >= 0)
+                _oled.drawLine(x - 1, prevY, x, y);
+            else
+                _oled.drawPixel(x, y);
+            prevY = y;
+        }
+    }
+
+    void Draw(const CRGB * pLeds, size_t cLeds, const char * status)
+    {
+        _oled.clearBuffer();
+        DrawText(status);
+        DrawPreview(pLeds, cLeds);
+        DrawSparkline(Render, 32, 'R');
+        DrawSparkline(Show,   43, 'S');
+        DrawSparkline(Idle,   54, 'I');
+    }
+
+    void StartPicture()
+    {
+        _pictureNext    = _next;
+        _pictureSamples = _cSamples;
+        _pictureMicros  = 0;
+    }
+
+    void FinishPicture()
+    {
+        _refreshMicros = _pictureMicros;
+        _bInvalid      = false;
+        _cPictures++;
+    }
+
+    // Mark every tile in [firstRow, firstRow + cRows) that differs from what the panel has.
+    // The buffer holds those rows starting at its beginning.
+
+    void FindChanges(int firstRow, int cRows)
+    {
+        const uint8_t * pBuffer = _oled.getBufferPtr();
+        int cColumns = TileColumns();
+
+        for (int row = firstRow; row < firstRow + cRows && row < MaxTileRows; row++)
+            for (int col = 0; col < cColumns; col++)
+            {
+                if (_bInvalid || TileDiffers(row, col, pBuffer + ((row - firstRow) * cColumns + col) * 8))
+                {
+                    _dirty[row] |= 1 << col;
+                    _cDirty++;
+                }
+            }
+    }
+
+    // Send up to budget changed tiles from rows [firstRow, firstRow + cRows), a run along a row at
+    // a time
+
+    void SendChanges(int firstRow, int cRows, size_t budget)
+    {
+        uint8_t * pBuffer = _oled.getBufferPtr();
+        int cColumns = TileColumns();
+
+        for (int row = firstRow; row < firstRow + cRows && row < MaxTileRows && budget; row++)
+        {
+            int col = 0;
+            while (_dirty[row] && budget && col < cColumns)
+            {
+                if (!(_dirty[row] & (1 << col)))
+                {
+                    col++;
+                    continue;
+                }
+
+                int run = 0;
+                while (col + run < cColumns && (_dirty[row] & (1 << (col + run))) && (size_t) run < budget)
+                    run++;
+
+                uint8_t * pTiles = pBuffer + ((row - firstRow) * cColumns + col) * 8;
+                u8x8_DrawTile(_oled.getU8x8(), col, row, run, pTiles);
+
+                for (int i = 0; i < run; i++)
+                {
+                    TileSent(row, col + i, pTiles + i * 8);
+                    _dirty[row] &= ~(1 << (col + i));
+                }
+                _cDirty     -= run;
+                _cTilesSent += run;
+                budget      -= run;
+                col         += run;
+            }
+        }
+    }
+
+  public:
+
+    OLEDDashboard(U8G2 & oled, size_t tilesPerCall = DefaultTilesPerCall)
+        : _oled(oled),
+          _tilesPerCall(tilesPerCall ? tilesPerCall : 1),
+          _pShadow(nullptr),
+          _cDirty(0),
+          _bInvalid(false),
+          _bandRow(0),
+          _next(0),
+          _cSamples(0),
+          _pictureNext(0),
+          _pictureSamples(0),
+          _cTilesSent(0),
+          _cPictures(0),
+          _worstMicros(0),
+          _pictureMicros(0),
+          _refreshMicros(0)
+    {
+        if (!IsPaged())
+            _pShadow = new uint8_t[MaxTileRows * MaxTileColumns * 8] { 0 };
+
+        const uint8_t blank[8] = { 0 };
+        for (int row = 0; row < MaxTileRows; row++)
+            for (int col = 0; col < MaxTileColumns; col++)
+                _tileHash[row][col] = TileHash(blank);      // The panel starts out cleared
+        memset(_dirty, 0, sizeof(_dirty));
+    }
+
+    ~OLEDDashboard()
+    {
+        delete [] _pShadow;
+    }
+
+    // AddSample
+    //
+    // Where one frame's time went: drawing it, handing it to the output, and sleeping until the next
+
+    void AddSample(uint32_t renderMicros, uint32_t showMicros, uint32_t idleMicros)
+    {
+        _samples[Render][_next] = min(renderMicros, (uint32_t) 65535);
+        _samples[Show][_next]   = min(showMicros, (uint32_t) 65535);
+        _samples[Idle][_next]   = min(idleMicros, (uint32_t) 65535);
+        _next = (_next + 1) % RingSize;
+        if (_cSamples < Samples)
+            _cSamples++;
+    }
+
+    // Invalidate
+    //
+    // Resends every tile of the next picture, whether it changed or not
+
+    void Invalidate()
+    {
+        _bInvalid = true;
+    }
+
+    // Update
+    //
+    // Call once a frame, after the display has been begun and cleared.  Returns true when this call
+    // finished putting a picture on the panel.
+
+    bool Update(const CRGB * pLeds, size_t cLeds, const char * status)
+    {
+        int64_t start = esp_timer_get_time();
+        bool    bDone = false;
+
+        if (IsPaged())
+        {
+            if (_bandRow == 0)
+                StartPicture();
+
+            _oled.setBufferCurrTileRow(_bandRow);
+            Draw(pLeds, cLeds, status);
+            FindChanges(_bandRow, BandRows());
+            SendChanges(_bandRow, BandRows(), MaxTileRows * MaxTileColumns);
+
+            _bandRow += BandRows();
+            if (_bandRow >= MaxTileRows)
+            {
+                _bandRow = 0;
+                bDone    = true;
+            }
+        }
+        else
+        {
+            if (!_cDirty)
+            {
+                StartPicture();
+                Draw(pLeds, cLeds, status);
+                FindChanges(0, MaxTileRows);
+            }
+            SendChanges(0, MaxTileRows, _tilesPerCall);
+            bDone = !_cDirty;
+        }
+
+        uint32_t elapsed = esp_timer_get_time() - start;
+        _pictureMicros += elapsed;
+        if (elapsed > _worstMicros)
+            _worstMicros = elapsed;
+        if (bDone)
+            FinishPicture();
+        return bDone;
+    }
+
+    // BenchmarkRefresh
+    //
+    // Average time, in uS, to draw and send an entire picture with every tile resent, in whichever
+    // buffer mode the display was built with.  Includes the I2C transfers, which is most of it.
+
+    float BenchmarkRefresh(const CRGB * pLeds, size_t cLeds, const char * status, int cPictures = 10)
+    {
+        while (_cDirty || _bandRow)                         // Finish whatever's in progress first
+            Update(pLeds, cLeds, status);
+
+        uint32_t total = 0;
+        for (int i = 0; i < cPictures; i++)
+        {
+            Invalidate();
+            while (!Update(pLeds, cLeds, status))
+                ;
+            total += _refreshMicros;
+        }
+        return cPictures ? (float) total / cPictures : 0.0f;
+    }
+
+    uint32_t TilesSent() const      { return _cTilesSent; }
+    uint32_t Pictures() const       { return _cPictures; }
+    uint32_t WorstMicros() const    { return _worstMicros; }
+    uint32_t RefreshMicros() const  { return _refreshMicros; }
+    size_t   BufferBytes()          { return (size_t) TileColumns() * BandRows() * 8; }
+};
@@ -0,0 +1,190 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        palettefade.h
+//
+// Description:
+//
+//   Crossfades from one 256-entry palette to another over a given number of
+//   seconds, blending only a bounded number of entries each frame.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+#include "gradienttable.h"
+#include "framecontext.h"
+
+// PaletteFader
+//
+// Blending all 256 entries every frame is most of a millisecond at 30 FPS and gets worse the faster
+// the loop runs, so the fade is done in steps instead.  Each step blends the whole palette at one
+// amount into a back page, a few dozen entries per frame, and the back page becomes the front one
+// only once every entry is done.  Color() reads the front page, so an effect always draws from a
+// palette that's entirely one step of the fade - never half of one step and half of the next.
+//
+// The amount for each step is taken from the clock at the time the step will be shown, so the
+// fade takes the same number of seconds whatever the frame rate; a faster loop just gets more,
+// smaller steps.  Starting a new fade part way through one fades from wherever it had got to.
+//
+// Update() flips the pages, so call it from the render loop before drawing.
+
+class PaletteFader
+{
+  public:
+
+    static const size_t DefaultEntriesPerFrame = 64;
+
+  private:
+
+    PaletteEntry           _from[256];          // The front page as it was when the fade started
+    PaletteEntry           _pages[2][256];
+    uint8_t                _front;
+
+    const GradientTable  * _pTable;             // Where we're fading to: a table in flash...
+    CRGBPalette16          _palette16;          // ...or a 16-entry palette, sampled as we go
+
+    size_t                 _entriesPerFrame;
+    uint32_t               _duration;           // In uS
+    uint64_t               _start;
+    uint16_t               _amount;             // Blend of the step being built, 0-256
+    size_t                 _next;               // Next entry of the back page to blend
+    bool                   _bFading;
+    bool                   _bStarting;          // FadeTo() has been called but Update() hasn't seen it yet
+
+    PaletteEntry Target(uint8_t index) const
+    {
+        if (_pTable)
+            return _pTable->Entries[index];
+        CRGB color = ColorFromPalette(_palette16, index);
+        return PaletteEntry { color.r, color.g, color.b };
+    }
+
+    static uint8_t Blend(uint8_t from, uint8_t to, uint16_t amount)
+    {
+        return (from * (256 - amount) + to * amount) >> 8;
+    }
+
+    void Begin(float seconds)
+    {
+        memcpy(_from, _pages[_front], sizeof(_from));
+        _duration  = seconds > 0 ? (uint32_t)(seconds * 1000000) : 0;
+        _next      = 0;
+        _bFading   = true;
+        _bStarting = true;
+    }
+
+  public:
+
+    PaletteFader(const GradientTable & initial, size_t entriesPerFrame = DefaultEntriesPerFrame)
+        : _front(0),
+          _pTable(&initial),
+          _entriesPerFrame(entriesPerFrame ? entriesPerFrame : 1),
+          _duration(0),
+          _start(0),
+          _amount(0),
+          _next(0),
+          _bFading(false),
+          _bStarting(false)
+    {
+        memcpy(_pages[0], initial.Entries, sizeof(_pages[0]));
+    }
+
+    // FadeTo
+    //
+    // Starts a fade to the new palette, beginning with the next Update().  A fade of zero seconds
+    // still goes out a step at a time, it's just the one step.
+
+    void FadeTo(const GradientTable & target, float seconds)
+    {
+        _pTable = &target;
+        Begin(seconds);
+    }
+
+    void FadeTo(const CRGBPalette16 & target, float seconds)
+    {
+        _pTable    = nullptr;
+        _palette16 = target;
+        Begin(seconds);
+    }
+
+    // Update
+    //
+    // Blends up to entriesPerFrame entries of the step in progress, and shows the step if that
+    // finished it
+
+    void Update(const FrameContext & frame)
+    {
+        if (!_bFading)
+            return;
+
+        if (_bStarting)
+        {
+            _start     = frame.Micros;
+            _bStarting = false;
+        }
+
+        if (_next == 0)
+        {
+            // Aim for when this step will be shown, a few frames from now
+
+            size_t   cFrames = (256 + _entriesPerFrame - 1) / _entriesPerFrame;
+            uint64_t shown   = frame.Micros - _start + (uint64_t)(cFrames - 1) * frame.DeltaMicros;
+            _amount = shown >= _duration ? 256 : (uint16_t)(shown * 256 / _duration);
+        }
+
+        PaletteEntry * pBack = _pages[_front ^ 1];
+        size_t end = _next + _entriesPerFrame < 256 ? _next + _entriesPerFrame : 256;
+        for (size_t i = _next; i < end; i++)
+        {
+            PaletteEntry to = Target(i);
+            pBack[i].r = Blend(_from[i].r, to.r, _amount);
+            pBack[i].g = Blend(_from[i].g, to.g, _amount);
+            pBack[i].b = Blend(_from[i].b, to.b, _amount);
+        }
+        _next = end;
+
+        if (_next == 256)
+        {
+            _front ^= 1;
+            _next   = 0;
+            if (_amount == 256)
+                _bFading = false;
+        }
+    }
+
+    bool IsFading() const
+    {
+        return _bFading;
+    }
+
+    // Color
+    //
+    // Same result as ColorFromPalette on a CRGBPalette256 with no blending
+
+    CRGB Color(uint8_t index) const
+    {
+        const PaletteEntry & entry = _pages[_front][index];
+        return CRGB(entry.r, entry.g, entry.b);
+    }
+
+    // Entries
+    //
+    // The whole front page, for code that maps many pixels through it at once.  Only good until
+    // the next Update().
+
+    const PaletteEntry * Entries() const
+    {
+        return _pages[_front];
+    }
+};
@@ -0,0 +1,198 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        palettemap.h
+//
+// Description:
+//
+//   Maps a whole frame of palette indices into the framebuffer in one pass,
+//   in place of a ColorFromPalette and a DrawFanPixels call per LED.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+#include <esp_timer.h>
+
+#include "ledgfx.h"
+#include "gradienttable.h"
+
+// FanPixelMap
+//
+// GetFanPixelOrder for every position at once.  Each order's table is worked out the first time
+// it's asked for, after which mapping a pixel is a single load instead of the modulo arithmetic
+// and lookups GetFanPixelOrder does.
+
+inline const uint16_t * FanPixelMap(PixelOrder order)
+{
+    static uint16_t maps[6][NUM_LEDS];
+    static bool     bBuilt[6] = { false };
+
+    int iMap;
+    switch (order)
+    {
+        case Reverse:   iMap = 1; break;
+        case BottomUp:  iMap = 2; break;
+        case TopDown:   iMap = 3; break;
+        case LeftRight: iMap = 4; break;
+        case RightLeft: iMap = 5; break;
+        default:        iMap = 0; break;
+    }
+
+    if (!bBuilt[iMap])
+    {
+        for (int i = 0; i < NUM_LEDS; i++)
+            maps[iMap][i] = GetFanPixelOrder(i, order);
+        bBuilt[iMap] = true;
+    }
+    return maps[iMap];
+}
+
+// MapPaletteRamp
+//
+// Fills count pixels with a ramp through a 256-entry palette: pixel i gets the color at index
+// start + i * step, both in 8.8 fixed point, wrapping around the palette the way a uint8_t index
+// does.  With NOBLEND the fraction is dropped; with LINEARBLEND it mixes the two entries either
+// side, so a ramp that steps less than one entry per pixel still changes smoothly.
+//
+// Pixels are overwritten rather than added to, which is the same thing on a cleared frame.
+// The palette can be anything with r, g and b members: a GradientTable's entries, a
+// PaletteFader's, or a CRGBPalette256's.
+
+template<typename Entry>
+void MapPaletteRamp(const Entry * pPalette, uint16_t start, int16_t step, PixelOrder order = Sequential,
+                    TBlendType blend = NOBLEND, size_t count = NUM_LEDS, CRGB * pLeds = g_LEDs)
+{
+    const uint16_t * pMap = FanPixelMap(order);
+    uint16_t index = start;
+
+    if (blend == NOBLEND)
+    {
+        for (size_t i = 0; i < count; i++, index += step)
+        {
+            const Entry & entry = pPalette[index >> 8];
+            pLeds[pMap[i]] = CRGB(entry.r, entry.g, entry.b);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++, index += step)
+    {
+        const Entry & a = pPalette[index >> 8];
+        const Entry & b = pPalette[(uint8_t)((index >> 8) + 1)];
+        uint16_t f2 = index & 0xFF, f1 = 256 - f2;
+        pLeds[pMap[i]] = CRGB((a.r * f1 + b.r * f2) >> 8, (a.g * f1 + b.g * f2) >> 8, (a.b * f1 + b.b * f2) >> 8);
+    }
+}
+
+inline void MapPaletteRamp(const GradientTable & table, uint16_t start, int16_t step, PixelOrder order = Sequential,
+                           TBlendType blend = NOBLEND, size_t count = NUM_LEDS, CRGB * pLeds = g_LEDs)
+{
+    MapPaletteRamp(table.Entries, start, step, order, blend, count, pLeds);
+}
+
+inline void MapPaletteRamp(const CRGBPalette256 & palette, uint16_t start, int16_t step, PixelOrder order = Sequential,
+                           TBlendType blend = NOBLEND, size_t count = NUM_LEDS, CRGB * pLeds = g_LEDs)
+{
+    MapPaletteRamp(palette.entries, start, step, order, blend, count, pLeds);
+}
+
+// MapPaletteIndices
+//
+// Same again for indices an effect has worked out itself, one byte per pixel
+
+template<typename Entry>
+void MapPaletteIndices(const Entry * pPalette, const uint8_t * pIndices, PixelOrder order = Sequential,
+                       size_t count = NUM_LEDS, CRGB * pLeds = g_LEDs)
+{
+    const uint16_t * pMap = FanPixelMap(order);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Entry & entry = pPalette[pIndices[i]];
+        pLeds[pMap[i]] = CRGB(entry.r, entry.g, entry.b);
+    }
+}
+
+inline void MapPaletteIndices(const GradientTable & table, const uint8_t * pIndices, PixelOrder order = Sequential,
+                              size_t count = NUM_LEDS, CRGB * pLeds = g_LEDs)
+{
+    MapPaletteIndices(table.Entries, pIndices, order, count, pLeds);
+}
+
+// PaletteMapStats
+//
+// Results from BenchmarkPaletteMap, in uS per frame of NUM_LEDS pixels
+
+struct PaletteMapStats
+{
+    float PerPixelMicros;               // ColorFromPalette on a CRGBPalette256, then DrawFanPixels, per LED
+    float TableMicros;                  // PaletteColor from a flash table, then DrawFanPixels, per LED
+    float BulkMicros;                   // MapPaletteRamp, no blending
+    float BulkBlendMicros;              // MapPaletteRamp with LINEARBLEND
+    bool  bMatches;                     // The unblended bulk frame came out the same as the per-LED one
+};
+
+// BenchmarkPaletteMap
+//
+// Draws the Seahawks scroll each way for the given number of frames.  Leaves the frame cleared.
+
+inline PaletteMapStats BenchmarkPaletteMap(int cFrames = 200)
+{
+    PaletteMapStats  stats = { 0.0f, 0.0f, 0.0f, 0.0f, true };
+    CRGBPalette256 * pPalette = new CRGBPalette256;
+    CRGB           * pExpected = new CRGB[NUM_LEDS];
+
+    for (int i = 0; i < 256; i++)
+        (*pPalette)[i] = PaletteColor(vu_SeahawksTable, i);
+
+    // Same ramp as DrawSeahawks: 255 / NUM_LEDS entries per pixel, scrolling a step a frame
+
+    const int16_t step = 255 * 256 / NUM_LEDS;
+
+    uint64_t start = esp_timer_get_time();
+    for (int f = 0; f < cFrames; f++)
+    {
+        fill_solid(g_LEDs, NUM_LEDS, CRGB::Black);
+        for (int i = 0; i < NUM_LEDS; i++)
+            DrawFanPixels(i, 1, ColorFromPalette(*pPalette, f + (i * step >> 8)), BottomUp);
+    }
+    stats.PerPixelMicros = (float)(esp_timer_get_time() - start) / cFrames;
+    memcpy(pExpected, g_LEDs, sizeof(CRGB) * NUM_LEDS);
+
+    start = esp_timer_get_time();
+    for (int f = 0; f < cFrames; f++)
+    {
+        fill_solid(g_LEDs, NUM_LEDS, CRGB::Black);
+        for (int i = 0; i < NUM_LEDS; i++)
+            DrawFanPixels(i, 1, PaletteColor(vu_SeahawksTable, f + (i * step >> 8)), BottomUp);
+    }
+    stats.TableMicros = (float)(esp_timer_get_time() - start) / cFrames;
+
+    // The ramp's fraction accumulates the same way the integer division above truncates, so the
+    // unblended frames should match exactly
+
+    start = esp_timer_get_time();
+    for (int f = 0; f < cFrames; f++)
+        MapPaletteRamp(vu_SeahawksTable, f << 8, step, BottomUp);
+    stats.BulkMicros = (float)(esp_timer_get_time() - start) / cFrames;
+    stats.bMatches = !memcmp(pExpected, g_LEDs, sizeof(CRGB) * NUM_LEDS);
+
+    start = esp_timer_get_time();
+    for (int f = 0; f < cFrames; f++)
+        MapPaletteRamp(vu_SeahawksTable, f << 8, step, BottomUp, LINEARBLEND);
+    stats.BulkBlendMicros = (float)(esp_timer_get_time() - start) / cFrames;
+
+    fill_solid(g_LEDs, NUM_LEDS, CRGB::Black);
+    delete pPalette;
+    delete [] pExpected;
+    return stats;
+}
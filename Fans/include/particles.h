@@ -0,0 +1,363 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        particles.h
+//
+// Description:
+//
+//   Fixed-capacity particle pool for sparks, balls and the like.  Particle
+//   state is kept as parallel float arrays so each integrator pass is one
+//   tight loop, and nothing is allocated after construction.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+#define FASTLED_INTERNAL
+#include <FastLED.h>
+
+#include "ledgfx.h"
+#include "framecontext.h"
+
+class ParticleSystem;
+
+// ParticleIntegrator
+//
+// Something that acts on every particle once per frame.  Forces run before positions are
+// advanced and adjust velocity; constraints run afterwards and can fix up position and velocity.
+
+class ParticleIntegrator
+{
+  public:
+
+    virtual ~ParticleIntegrator()
+    {
+    }
+
+    virtual void ApplyForces(ParticleSystem & particles, float dt)
+    {
+    }
+
+    virtual void ApplyConstraints(ParticleSystem & particles, float dt)
+    {
+    }
+};
+
+class ParticleSystem
+{
+  public:
+
+    static const size_t MaxIntegrators = 4;
+
+    // Particle state, one entry per live particle in [0, Count())
+
+    float * Position;                   // Pixels from the start of the strip
+    float * Velocity;                   // Pixels per second
+    float * Age;                        // Seconds since spawn
+    float * Life;                       // Seconds to live, or 0 to live until killed
+    float * Elasticity;                 // Fraction of speed kept when bouncing
+    CRGB  * Color;
+
+  private:
+
+    size_t               _capacity;
+    size_t               _count;
+    float                _length;       // Particles that leave [0, _length) for good are killed
+    ParticleIntegrator * _integrators[MaxIntegrators];
+    size_t               _cIntegrators;
+
+  public:
+
+    ParticleSystem(size_t capacity, size_t length)
+        : _capacity(capacity),
+          _count(0),
+          _length(length),
+          _cIntegrators(0)
+    {
+        Position   = new float[capacity];
+        Velocity   = new float[capacity];
+        Age        = new float[capacity];
+        Life       = new float[capacity];
+        Elasticity = new float[capacity];
+        Color      = new CRGB[capacity];
+    }
+
+    virtual ~ParticleSystem()
+    {
+        delete [] Position;
+        delete [] Velocity;
+        delete [] Age;
+        delete [] Life;
+        delete [] Elasticity;
+        delete [] Color;
+    }
+
+    size_t Count() const    { return _count; }
+    size_t Capacity() const { return _capacity; }
+    float  Length() const   { return _length; }
+
+    bool AddIntegrator(ParticleIntegrator * pIntegrator)
+    {
+        if (_cIntegrators == MaxIntegrators)
+            return false;
+        _integrators[_cIntegrators++] = pIntegrator;
+        return true;
+    }
+
+    // Spawn
+    //
+    // Returns the new particle's index, or -1 if the pool is full
+
+    int Spawn(float position, float velocity, CRGB color, float life = 0.0f, float elasticity = 1.0f)
+    {
+        if (_count == _capacity)
+            return -1;
+
+        size_t i = _count++;
+        Position[i]   = position;
+        Velocity[i]   = velocity;
+        Age[i]        = 0.0f;
+        Life[i]       = life;
+        Elasticity[i] = elasticity;
+        Color[i]      = color;
+        return i;
+    }
+
+    // Kill
+    //
+    // Moves the last particle into the hole, so indices above i are not stable across a kill
+
+    void Kill(size_t i)
+    {
+        size_t last = --_count;
+        Position[i]   = Position[last];
+        Velocity[i]   = Velocity[last];
+        Age[i]        = Age[last];
+        Life[i]       = Life[last];
+        Elasticity[i] = Elasticity[last];
+        Color[i]      = Color[last];
+    }
+
+    void Clear()
+    {
+        _count = 0;
+    }
+
+    // Update
+    //
+    // Advances the simulation by the frame's delta time and retires expired or escaped particles
+
+    void Update(const FrameContext & frame)
+    {
+        float dt = min(frame.DeltaSeconds(), 0.1f);     // Don't let a long stall launch everything into orbit
+
+        for (size_t j = 0; j < _cIntegrators; j++)
+            _integrators[j]->ApplyForces(*this, dt);
+
+        for (size_t i = 0; i < _count; i++)
+        {
+            Position[i] += Velocity[i] * dt;
+            Age[i]      += dt;
+        }
+
+        for (size_t j = 0; j < _cIntegrators; j++)
+            _integrators[j]->ApplyConstraints(*this, dt);
+
+        // Walk backwards so that Kill's swap only ever pulls in particles we've already checked
+
+        for (size_t i = _count; i-- > 0; )
+        {
+            bool bExpired = Life[i] > 0.0f && Age[i] >= Life[i];
+            bool bEscaped = (Position[i] < -1.0f && Velocity[i] <= 0.0f) || (Position[i] > _length && Velocity[i] >= 0.0f);
+            if (bExpired || bEscaped)
+                Kill(i);
+        }
+    }
+
+    // Render
+    //
+    // Each particle is one pixel wide at a fractional position, so it straddles two LEDs and
+    // moves smoothly.  Particles with a finite life fade out as they age.
+
+    void Render(PixelOrder order = Sequential, bool bMirrored = false) const
+    {
+        for (size_t i = 0; i < _count; i++)
+        {
+            float pos = Position[i];
+            if (pos < 0.0f || pos > _length - 1.0f)
+                continue;
+
+            CRGB color = Color[i];
+            if (Life[i] > 0.0f)
+                color = ColorFraction(color, 1.0f - Age[i] / Life[i]);
+
+            DrawFanPixels(pos, 1.0f, color, order);
+            if (bMirrored)
+                DrawFanPixels(_length - 1.0f - pos, 1.0f, color, order);
+        }
+    }
+
+    // Render
+    //
+    // Same again into any buffer treated as one straight strip, for strips that aren't the fans.
+    // Each particle is split across its two LEDs by its fractional position.
+
+    void Render(CRGB * pLeds, size_t cLeds, bool bMirrored = false) const
+    {
+        float top = min(_length, (float) cLeds) - 1.0f;
+        for (size_t i = 0; i < _count; i++)
+        {
+            float pos = Position[i];
+            if (pos < 0.0f || pos > top)
+                continue;
+
+            CRGB color = Color[i];
+            if (Life[i] > 0.0f)
+                color = ColorFraction(color, 1.0f - Age[i] / Life[i]);
+
+            for (int pass = 0; pass < (bMirrored ? 2 : 1); pass++, pos = top - pos)
+            {
+                size_t  iPos = (size_t) pos;
+                uint8_t frac = (uint8_t)((pos - iPos) * 255.0f);
+                pLeds[iPos] += CRGB(color).nscale8_video(255 - frac);
+                if (frac && iPos + 1 < cLeds)
+                    pLeds[iPos + 1] += CRGB(color).nscale8_video(frac);
+            }
+        }
+    }
+};
+
+// GravityIntegrator
+//
+// Constant acceleration in pixels per second squared; negative pulls toward pixel 0
+
+class GravityIntegrator : public ParticleIntegrator
+{
+    float _acceleration;
+
+  public:
+
+    GravityIntegrator(float acceleration) : _acceleration(acceleration)
+    {
+    }
+
+    virtual void ApplyForces(ParticleSystem & particles, float dt) override
+    {
+        float dv = _acceleration * dt;
+        for (size_t i = 0; i < particles.Count(); i++)
+            particles.Velocity[i] += dv;
+    }
+};
+
+// DragIntegrator
+//
+// Velocity decays by the given fraction per second
+
+class DragIntegrator : public ParticleIntegrator
+{
+    float _drag;
+
+  public:
+
+    DragIntegrator(float drag) : _drag(drag)
+    {
+    }
+
+    virtual void ApplyForces(ParticleSystem & particles, float dt) override
+    {
+        float keep = max(0.0f, 1.0f - _drag * dt);
+        for (size_t i = 0; i < particles.Count(); i++)
+            particles.Velocity[i] *= keep;
+    }
+};
+
+// BounceIntegrator
+//
+// Reflects particles off the ends of the strip, losing speed according to their elasticity.  If
+// a kick speed is given, a particle that has bounced itself out of energy is relaunched with it.
+
+class BounceIntegrator : public ParticleIntegrator
+{
+    float _minSpeed;
+    float _kickSpeed;
+    bool  _bCeiling;
+
+  public:
+
+    BounceIntegrator(bool bCeiling = true, float kickSpeed = 0.0f, float minSpeed = 0.0f)
+        : _minSpeed(minSpeed),
+          _kickSpeed(kickSpeed),
+          _bCeiling(bCeiling)
+    {
+    }
+
+    virtual void ApplyConstraints(ParticleSystem & particles, float dt) override
+    {
+        float top = particles.Length() - 1.0f;
+
+        for (size_t i = 0; i < particles.Count(); i++)
+        {
+            float & pos = particles.Position[i];
+            float & vel = particles.Velocity[i];
+
+            if (pos < 0.0f && vel < 0.0f)
+            {
+                pos = 0.0f;
+                vel = -vel * particles.Elasticity[i];
+                if (vel < _minSpeed && _kickSpeed > 0.0f)
+                    vel = _kickSpeed * particles.Elasticity[i];
+            }
+            else if (_bCeiling && pos > top && vel > 0.0f)
+            {
+                pos = top;
+                vel = -vel * particles.Elasticity[i];
+            }
+        }
+    }
+};
+
+// BenchmarkParticles
+//
+// Runs a pool of sparks bouncing under gravity and drag on a strip of cLeds for the given number
+// of frames and returns the throughput in particles per millisecond (update plus render).  The
+// strip is a scratch buffer, so any length can be tried whatever the fans are, and the frame
+// being shown isn't touched.
+
+float BenchmarkParticles(size_t cParticles, size_t cLeds = NUM_LEDS, int cFrames = 100)
+{
+    ParticleSystem    particles(cParticles, cLeds);
+    GravityIntegrator gravity(-20.0f);
+    DragIntegrator    drag(0.1f);
+    BounceIntegrator  bounce;
+    CRGB *            pLeds = new CRGB[cLeds];
+
+    particles.AddIntegrator(&gravity);
+    particles.AddIntegrator(&drag);
+    particles.AddIntegrator(&bounce);
+
+    FastRandom random(1);
+    while (particles.Spawn(random.NextFloat() * (cLeds - 1), random.NextFloat() * 40.0f - 20.0f, CRGB::White, 0.0f, 0.8f) >= 0)
+        ;
+
+    FastRandom   frameRandom;
+    FrameContext frame { 0, 16667, 0, frameRandom, 0 };   // Fixed 60 FPS timestep
+
+    uint64_t cMoved = 0;                                    // Particles that escape the top are gone, so count the live ones
+    uint64_t start  = esp_timer_get_time();
+    for (int i = 0; i < cFrames; i++)
+    {
+        fill_solid(pLeds, cLeds, CRGB::Black);
+        particles.Update(frame);
+        particles.Render(pLeds, cLeds);
+        cMoved += particles.Count();
+        frame.FrameNumber++;
+    }
+    uint64_t elapsed = esp_timer_get_time() - start;
+
+    delete [] pLeds;
+    return elapsed ? cMoved * 1000.0f / elapsed : 0.0f;
+}
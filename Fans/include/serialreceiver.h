@@ -0,0 +1,362 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        serialreceiver.h
+//
+// Description:
+//
+//   Receives frames from a host over the USB serial port at high baud rates.
+//   Frames are checksummed and assembled on a task of their own; the render
+//   loop just picks up the newest complete one.  The parser is portable so the
+//   host tools can run the same code against a pty.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#endif
+
+#include "framecodec.h"
+#include "crc16.h"
+
+// Serial frame format
+//
+//   0xA5 0x5A         sync
+//   type              SerialRaw (RGB, three bytes per LED) or SerialEncoded (a framecodec.h frame)
+//   length            payload bytes, u16 little-endian
+//   payload
+//   crc               CRC-16/CCITT-FALSE of type, length and payload, u16 little-endian
+//
+// Anything that doesn't parse is skipped until the next sync.  Encoded deltas need every frame
+// before them, so after a bad frame the receiver waits for the next keyframe.
+
+enum SerialFrameType : uint8_t
+{
+    SerialRaw     = 0x01,
+    SerialEncoded = 0x02
+};
+
+static const uint8_t SerialSync0 = 0xA5;
+static const uint8_t SerialSync1 = 0x5A;
+
+// SerialFrameReceiver
+//
+// Triple buffered: the parser owns a back buffer it assembles into, the render loop owns a front
+// buffer, and the newest finished frame sits in between.  Handing a buffer over is one atomic
+// exchange, so neither side ever waits for the other.
+
+class SerialFrameReceiver
+{
+  public:
+
+    static const uint32_t DefaultBaud     = 2000000;
+    static const size_t   RxBufferSize    = 16384;          // UART driver's receive ring; ~80ms at 2Mbaud
+
+  private:
+
+    enum State { Sync0, Sync1, Type, LengthLow, LengthHigh, Payload, CrcLow, CrcHigh };
+
+    static const uint8_t Fresh = 0x80;                       // Set in _latest until the render loop takes it
+
+    size_t       _cBytes;
+    uint8_t    * _buffers[3];
+    uint8_t      _back;                 // Owned by the parser
+    uint8_t      _front;                // Owned by the render loop
+    uint8_t      _latest;               // Index of the newest finished frame, plus Fresh
+
+    uint8_t    * _pPayload;             // Encoded payloads are checked before they're decoded
+    uint8_t    * _pDecoded;             // Last decoded frame, which the next delta applies to
+    FrameDecoder _decoder;
+    bool         _bNeedKey;
+
+    State        _state;
+    uint8_t      _type;
+    uint16_t     _length;
+    uint16_t     _received;
+    uint16_t     _crc;
+    uint8_t    * _pTarget;
+    int64_t      _lastFrame;
+
+    uint32_t     _cFrames;              // Passed the checksum and handed over
+    uint32_t     _cPresented;
+    uint32_t     _cOverwritten;         // Replaced by a newer frame before the render loop got to it
+    uint32_t     _cCrcErrors;
+    uint32_t     _cBadHeaders;          // Unknown type or impossible length
+    uint32_t     _cWaitingForKey;       // Deltas discarded until a keyframe resynced us
+
+    static void Count(uint32_t & counter)
+    {
+        __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED);
+    }
+
+    void Publish(int64_t now)
+    {
+        uint8_t previous = __atomic_exchange_n(&_latest, (uint8_t)(_back | Fresh), __ATOMIC_ACQ_REL);
+        if (previous & Fresh)
+            Count(_cOverwritten);
+        _back = previous & ~Fresh;
+        __atomic_store_n(&_lastFrame, now, __ATOMIC_RELAXED);
+        Count(_cFrames);
+    }
+
+    // Header is in; decide where the payload goes, or reject it
+
+    bool BeginPayload()
+    {
+        if (_type == SerialRaw && _length == _cBytes)
+        {
+            _pTarget = _buffers[_back];                     // Raw frames land straight in the back buffer
+            return true;
+        }
+        if (_type == SerialEncoded && _length > 0 && _length <= MaxEncodedSize(_cBytes))
+        {
+            _pTarget = _pPayload;
+            return true;
+        }
+        Count(_cBadHeaders);
+        return false;
+    }
+
+    void EndPayload(int64_t now)
+    {
+        if (_type == SerialRaw)
+        {
+            _bNeedKey = true;                               // Our decoded reference is now out of date
+            Publish(now);
+            return;
+        }
+
+        if (_bNeedKey && _pPayload[0] != FrameKey)
+        {
+            Count(_cWaitingForKey);
+            return;
+        }
+
+        size_t used;
+        _decoder.Reset();
+        if (_decoder.Feed(_pPayload, _length, used) != FrameDecoder::FrameComplete || used != _length)
+        {
+            Count(_cBadHeaders);
+            _bNeedKey = true;
+            return;
+        }
+
+        _bNeedKey = false;
+        memcpy(_buffers[_back], _pDecoded, _cBytes);
+        Publish(now);
+    }
+
+#ifdef ARDUINO
+    static void ReceiveTaskEntry(void * pv)
+    {
+        SerialFrameReceiver * pThis = (SerialFrameReceiver *) pv;
+        uint8_t buffer[512];
+
+        for (;;)
+        {
+            int cb = Serial.available();
+            if (cb <= 0)
+            {
+                vTaskDelay(1);
+                continue;
+            }
+            cb = Serial.readBytes(buffer, min(cb, (int) sizeof(buffer)));
+            pThis->Feed(buffer, cb, esp_timer_get_time());
+        }
+    }
+#endif
+
+  public:
+
+    SerialFrameReceiver(size_t cLeds)
+        : _cBytes(cLeds * 3),
+          _back(0),
+          _front(1),
+          _latest(2),
+          _pPayload(new uint8_t[MaxEncodedSize(_cBytes)]),
+          _pDecoded(new uint8_t[_cBytes]),
+          _decoder(_pDecoded, _cBytes),
+          _bNeedKey(true),
+          _state(Sync0),
+          _lastFrame(0),
+          _cFrames(0),
+          _cPresented(0),
+          _cOverwritten(0),
+          _cCrcErrors(0),
+          _cBadHeaders(0),
+          _cWaitingForKey(0)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            _buffers[i] = new uint8_t[_cBytes];
+            memset(_buffers[i], 0, _cBytes);
+        }
+        memset(_pDecoded, 0, _cBytes);
+    }
+
+    virtual ~SerialFrameReceiver()
+    {
+        for (int i = 0; i < 3; i++)
+            delete [] _buffers[i];
+        delete [] _pPayload;
+        delete [] _pDecoded;
+    }
+
+#ifdef ARDUINO
+    // Start
+    //
+    // Opens the serial port at the given baud rate with a large receive buffer and parses on a task
+    // of its own.  Call it in place of Serial.begin(); printing still works as usual.
+
+    bool Start(uint32_t baud = DefaultBaud, int core = 0, UBaseType_t priority = 2)
+    {
+        Serial.setRxBufferSize(RxBufferSize);
+        Serial.begin(baud);
+        return xTaskCreatePinnedToCore(ReceiveTaskEntry, "Serial Receiver", 4096, this, priority, nullptr, core) == pdPASS;
+    }
+#endif
+
+    // Feed
+    //
+    // Runs bytes through the parser.  Called from the receive task, or directly by host tools.
+
+    void Feed(const uint8_t * p, size_t cb, int64_t now)
+    {
+        const uint8_t * pEnd = p + cb;
+
+        while (p < pEnd)
+        {
+            if (_state == Payload)
+            {
+                size_t run = _length - _received;
+                if (run > (size_t)(pEnd - p))
+                    run = pEnd - p;
+                memcpy(_pTarget + _received, p, run);
+                _crc       = Crc16(_crc, p, run);
+                _received += run;
+                p         += run;
+                if (_received == _length)
+                    _state = CrcLow;
+                continue;
+            }
+
+            uint8_t b = *p++;
+            switch (_state)
+            {
+                case Sync0:
+                    if (b == SerialSync0)
+                        _state = Sync1;
+                    break;
+
+                case Sync1:
+                    _state = b == SerialSync1 ? Type : b == SerialSync0 ? Sync1 : Sync0;
+                    break;
+
+                case Type:
+                    _type  = b;
+                    _crc   = Crc16(0xFFFF, b);
+                    _state = LengthLow;
+                    break;
+
+                case LengthLow:
+                    _length = b;
+                    _crc    = Crc16(_crc, b);
+                    _state  = LengthHigh;
+                    break;
+
+                case LengthHigh:
+                    _length  |= b << 8;
+                    _crc      = Crc16(_crc, b);
+                    _received = 0;
+                    _state    = BeginPayload() ? Payload : Sync0;
+                    break;
+
+                case CrcLow:
+                    _crc  ^= b;
+                    _state = CrcHigh;
+                    break;
+
+                case CrcHigh:
+                    _crc  ^= b << 8;
+                    _state = Sync0;
+                    if (_crc == 0)
+                    {
+                        EndPayload(now);
+                    }
+                    else
+                    {
+                        Count(_cCrcErrors);
+                        _bNeedKey = true;
+                    }
+                    break;
+
+                case Payload:
+                    break;
+            }
+        }
+    }
+
+    // IsStreaming
+    //
+    // True while good frames have been arriving within the last second
+
+    bool IsStreaming(int64_t now) const
+    {
+        int64_t last = __atomic_load_n(&_lastFrame, __ATOMIC_RELAXED);
+        return last && now - last < 1000000;
+    }
+
+    // Present
+    //
+    // Copies the newest complete frame into pLeds (RGB, three bytes per LED).  Returns false,
+    // leaving pLeds alone, if nothing new has arrived since last time.
+
+    bool Present(void * pLeds)
+    {
+        if (!(__atomic_load_n(&_latest, __ATOMIC_ACQUIRE) & Fresh))
+            return false;
+
+        _front = __atomic_exchange_n(&_latest, _front, __ATOMIC_ACQ_REL) & ~Fresh;
+        memcpy(pLeds, _buffers[_front], _cBytes);
+        Count(_cPresented);
+        return true;
+    }
+
+    uint32_t ReceivedFrames() const    { return _cFrames; }
+    uint32_t PresentedFrames() const   { return _cPresented; }
+    uint32_t OverwrittenFrames() const { return _cOverwritten; }
+    uint32_t CrcErrors() const         { return _cCrcErrors; }
+    uint32_t BadHeaders() const        { return _cBadHeaders; }
+    uint32_t WaitingForKey() const     { return _cWaitingForKey; }
+};
+
+// BuildSerialFrame
+//
+// Wraps a payload for sending; pOut needs room for the payload plus 7 bytes.  Used by the host
+// sender, and by anything that wants to echo frames back out.
+
+inline size_t BuildSerialFrame(SerialFrameType type, const uint8_t * pPayload, uint16_t cb, uint8_t * pOut)
+{
+    uint8_t * p = pOut;
+    *p++ = SerialSync0;
+    *p++ = SerialSync1;
+    *p++ = type;
+    *p++ = cb & 0xFF;
+    *p++ = cb >> 8;
+    memcpy(p, pPayload, cb);
+    p += cb;
+
+    uint16_t crc = Crc16(0xFFFF, pOut + 2, cb + 3);
+    *p++ = crc & 0xFF;
+    *p++ = crc >> 8;
+    return p - pOut;
+}
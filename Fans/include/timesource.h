@@ -0,0 +1,45 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        timesource.h
+//
+// Description:
+//
+//   Interface between the frame clock and anything that can supply a
+//   timebase shared between boards.  Kept free of Arduino dependencies so
+//   the host tools can implement it too.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+// TimeSource
+//
+// Maps this board's clock onto a timebase shared with other boards, so effects built on the beat
+// functions stay in phase across controllers
+
+class TimeSource
+{
+  public:
+
+    virtual ~TimeSource()
+    {
+    }
+
+    virtual int64_t SharedMicros(int64_t localMicros) const = 0;
+
+    // StepCount
+    //
+    // Goes up each time the timebase jumps rather than being steered, e.g. when the server
+    // restarts.  A jump can be backwards, so clocks that hold time monotonic start over from it.
+
+    virtual uint32_t StepCount() const
+    {
+        return 0;
+    }
+};
@@ -0,0 +1,81 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        timingmodel.h
+//
+// Description:
+//
+//   Predicts how long it takes to clock a frame out to WS2812-style strips,
+//   and therefore the best frame rate a given wiring layout can reach.  Has
+//   no Arduino dependencies so the same code runs on the host.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+
+// StripTiming
+//
+// Defaults are for WS2812B at 800kHz: 24 bits of 1.25uS each per LED, then a latch (reset) time
+// of at least 280uS before the next frame can start.  ChannelSetupMicros covers the per-channel
+// driver overhead of starting a transmission.
+
+struct StripTiming
+{
+    float BitMicros;
+    int   BitsPerLED;
+    float ResetMicros;
+    float ChannelSetupMicros;
+};
+
+static const StripTiming WS2812BTiming = { 1.25f, 24, 300.0f, 20.0f };
+
+// PredictFrameMicros
+//
+// Segments are spread across cChannels outputs that transmit concurrently (RMT channels or I2S
+// lanes).  With one channel everything goes out back to back; with enough channels the frame takes
+// as long as the longest segment.  Segments beyond the channel count queue up behind the earlier
+// ones, round-robin, the way the ESP32 RMT driver hands channels back out.
+
+inline float PredictFrameMicros(const size_t * segmentLengths, size_t cSegments, size_t cChannels, const StripTiming & timing = WS2812BTiming)
+{
+    if (cChannels == 0 || cSegments == 0)
+        return 0.0f;
+
+    const size_t MaxChannels = 16;
+    if (cChannels > MaxChannels)
+        cChannels = MaxChannels;
+
+    float busy[MaxChannels] = { 0 };
+    float ledMicros = timing.BitMicros * timing.BitsPerLED;
+
+    for (size_t i = 0; i < cSegments; i++)
+    {
+        size_t least = 0;                           // Next segment goes to whichever channel frees up first
+        for (size_t c = 1; c < cChannels; c++)
+            if (busy[c] < busy[least])
+                least = c;
+        busy[least] += timing.ChannelSetupMicros + segmentLengths[i] * ledMicros;
+    }
+
+    float longest = 0.0f;
+    for (size_t c = 0; c < cChannels; c++)
+        if (busy[c] > longest)
+            longest = busy[c];
+
+    return longest + timing.ResetMicros;
+}
+
+// PredictMaxFPS
+//
+// Upper bound on the frame rate from wire time alone; rendering only ever makes it worse
+
+inline float PredictMaxFPS(const size_t * segmentLengths, size_t cSegments, size_t cChannels, const StripTiming & timing = WS2812BTiming)
+{
+    float micros = PredictFrameMicros(segmentLengths, cSegments, cChannels, timing);
+    return micros > 0.0f ? 1000000.0f / micros : 0.0f;
+}
@@ -2,13 +2,14 @@
 //
 // NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
 //
-// File:        
+// File:        twinkle.h
 //
 // Description:
 //
-//   
+//   Random colored stars that fade in and out
 //
 // History:     Sep-15-2020     davepl      Created
+//              Oct-19-2026     davepl      TwinkleEffect with star lifetimes
 //
 //---------------------------------------------------------------------------
 
@@ -17,6 +18,7 @@
 #include <FastLED.h>
 
 #include "ledgfx.h"
+#include "framecontext.h"
 
 static const CRGB TwinkleColors [] = 
 {
@@ -27,14 +29,126 @@ static const CRGB TwinkleColors [] =
     CRGB::Yellow
 };
 
-void DrawTwinkle()
+// TwinkleEffect
+//
+// Stars pop up at random pixels at a given average rate, fade in, then fade back out over their
+// lifetime.  Only the live stars are kept, in a compact list, so the work per frame depends on how
+// many stars are lit and not on how long the strip is.  Each star writes just its own pixel and
+// blacks it out again when it dies, so the strip doesn't need to be cleared underneath it.  A bit
+// per pixel marks the ones a star holds, and new stars don't land on those, so one star going
+// out never blanks another.
+//
+// Stars are random, so unlike the marquee and comets this effect doesn't line up across
+// controllers on a shared clock; it only keeps the same rate of stars.
+
+class TwinkleEffect
 {
-    static int passCount = 0;
-    if (passCount++ == FastLED.count()/4)
+  private:
+
+    struct Star
+    {
+        uint16_t Pixel;
+        float    Age;                   // Seconds since it appeared
+        float    Life;                  // Seconds from appearing to gone
+        CRGB     Color;
+    };
+
+    Star     * _stars;
+    uint32_t * _pTaken;                 // Bit per pixel that a live star is on
+    size_t     _cStars;
+    size_t     _maxStars;
+    size_t     _cLength;
+    float      _starsPerSecond;
+    float      _lifetime;
+    float      _fadeIn;                 // Fraction of the lifetime spent getting brighter
+    float      _spawnDebt;              // Fractional stars owed from previous frames
+    FastRandom _random;
+
+  public:
+
+    TwinkleEffect(size_t cLength, float starsPerSecond = 5.0f, float lifetime = 2.0f, float fadeIn = 0.25f, size_t maxStars = 0)
+        : _cStars(0),
+          _maxStars(maxStars ? maxStars : (size_t)(starsPerSecond * lifetime * 2) + 1),   // Twice the steady-state count
+          _cLength(cLength),
+          _starsPerSecond(starsPerSecond),
+          _lifetime(lifetime),
+          _fadeIn(fadeIn),
+          _spawnDebt(0)
     {
-        passCount = 0;
-        FastLED.clear(false);
+        _stars  = new Star[_maxStars];
+        _pTaken = new uint32_t[(cLength + 31) / 32]();
     }
-    FastLED.leds()[random(FastLED.count())] = TwinkleColors[random(0, ARRAYSIZE(TwinkleColors))];
-    delay(200);       
-}
\ No newline at end of file
+
+    virtual ~TwinkleEffect()
+    {
+        delete [] _stars;
+        delete [] _pTaken;
+    }
+
+    size_t ActiveStars() const
+    {
+        return _cStars;
+    }
+
+    void Draw(const FrameContext & frame)
+    {
+        float dt = min(frame.DeltaSeconds(), 0.1f);
+        CRGB * pLeds = g_LEDs;
+
+        // Age out and draw the stars we already have
+
+        for (size_t i = 0; i < _cStars; )
+        {
+            Star & star = _stars[i];
+            star.Age += dt;
+
+            if (star.Age >= star.Life)
+            {
+                pLeds[star.Pixel] = CRGB::Black;
+                _pTaken[star.Pixel >> 5] &= ~(1u << (star.Pixel & 31));
+                star = _stars[--_cStars];           // Fill the hole with the last star, then look at it
+                continue;
+            }
+
+            float t     = star.Age / star.Life;
+            float level = t < _fadeIn ? t / _fadeIn : (1.0f - t) / (1.0f - _fadeIn);
+            pLeds[star.Pixel] = CRGB(star.Color).nscale8_video(level * 255);
+            i++;
+        }
+
+        // Then bring in however many new ones are due this frame
+
+        _spawnDebt += _starsPerSecond * dt;
+        while (_spawnDebt >= 1.0f)
+        {
+            _spawnDebt -= 1.0f;
+            if (_cStars == _maxStars)
+                continue;
+
+            // A few tries at a free pixel; on a crowded strip the star just doesn't appear
+
+            uint16_t pixel = 0;
+            bool     bFree = false;
+            for (int tries = 0; tries < 4 && !bFree; tries++)
+            {
+                pixel = _random.Next(_cLength);
+                bFree = !(_pTaken[pixel >> 5] & (1u << (pixel & 31)));
+            }
+            if (!bFree)
+                continue;
+            _pTaken[pixel >> 5] |= 1u << (pixel & 31);
+
+            Star & star = _stars[_cStars++];
+            star.Pixel = pixel;
+            star.Age   = 0.0f;
+            star.Life  = _lifetime * (0.5f + _random.NextFloat());
+            star.Color = TwinkleColors[_random.Next(ARRAYSIZE(TwinkleColors))];
+        }
+    }
+};
+
+void DrawTwinkle(const FrameContext & frame)
+{
+    static TwinkleEffect twinkle(NUM_LEDS);
+    twinkle.Draw(frame);
+}
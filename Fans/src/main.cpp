@@ -17,12 +17,15 @@
 
 #include <Arduino.h>            // Arduino Framework
 #include <U8g2lib.h>            // For text on the little on-chip OLED
+#include <WiFi.h>               // For streaming frames from a show server
 #define FASTLED_INTERNAL        // Suppress build banner
 #include <FastLED.h>
 
 #define OLED_CLOCK  15          // Pins for the OLED display
 #define OLED_DATA   4
 #define OLED_RESET  16
+#define OLED_I2C_HZ 400000      // Hardware I2C clock for the OLED; the SSD1306 is specified to 400kHz
+#define OLED_PAGE_BUFFER 0      // 0 for U8g2's 1K full frame buffer, 1 or 2 for its 128 or 256 byte page buffer
 
 #define FAN_SIZE       16       // How many pixels per fan
 #define NUM_FANS       3        // Number of fans in the strans
@@ -30,38 +33,659 @@
 #define NUM_LEDS       (FAN_SIZE*NUM_FANS)
 #define LED_PIN        5
 
+#define PARALLEL_OUTPUT 0       // 1 to give each fan its own data pin, sent concurrently
+#define LED_PINS       5, 18, 19 // Data pins used for parallel output, one segment each
+#define OUTPUT_CORE    1        // Core the LED output task (and its RMT interrupt) runs on, off the network core; or -1 to show from loop()
+#define OUTPUT_STRESS_TEST 0    // 1 to hammer the output core with a busy timer interrupt
+
+#define ENABLE_STREAMING 0      // 1 to accept frames from a show server over WiFi
+#define WIFI_SSID      "your-ssid"
+#define WIFI_PASSWORD  "your-password"
+
+#define CLOCK_SYNC     0        // 1 to keep effects in phase with the other controllers over WiFi
+#define CLOCK_SERVER   ""       // Address of the board or host the others follow; "" for this board to be it
+
+#define SERIAL_INPUT   0        // 1 to accept frames from a host over the USB serial port
+#define SERIAL_BAUD    2000000  // Baud rate for serial frame input
+
 CRGB g_LEDs[NUM_LEDS] = {0};    // Frame buffer for FastLED
 
+#if OLED_PAGE_BUFFER == 1
+U8G2_SSD1306_128X64_NONAME_1_HW_I2C g_OLED(U8G2_R2, OLED_RESET, OLED_CLOCK, OLED_DATA);
+#elif OLED_PAGE_BUFFER == 2
+U8G2_SSD1306_128X64_NONAME_2_HW_I2C g_OLED(U8G2_R2, OLED_RESET, OLED_CLOCK, OLED_DATA);
+#else
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C g_OLED(U8G2_R2, OLED_RESET, OLED_CLOCK, OLED_DATA);
-int g_lineHeight = 0;
+#endif
 int g_Brightness = 255;         // 0-255 LED brightness scale
 int g_PowerLimit = 3000;         // 900mW Power Limit
+int g_FanPowerLimit = 1500;     // mW each fan's injection point can supply, or 0 for no per-fan limit
+int g_TargetFPS = 30;           // Frame rate the loop paces itself to, or 0 to run flat out
+int g_FireCooling = 0;          // Overrides for the fire effects' cooling and sparking, or 0 for their own
+int g_FireSparking = 0;
+uint32_t g_ShellIdleMicros = 0; // Worst time the command shell has taken to find nothing to do
 
 #include "ledgfx.h"
+#include "ledoutput.h"
+#include "framecontext.h"
 #include "comet.h"
 #include "marquee.h"
 #include "twinkle.h"
 #include "fire.h"
+#include "particles.h"
+#include "bounce.h"
+#include "framereceiver.h"
+#include "serialreceiver.h"
+#include "clocksync.h"
+#include "framecodec.h"
+#include "commandshell.h"
+#include "config.h"
+#include "palettefade.h"
+#include "palettemap.h"
+#include "oleddash.h"
 
+FrameClock g_FrameClock;        // Reads the clock once per frame for all effects
+LEDOutput  g_Output;            // Sends frames to the strip, skipping ones that haven't changed
 
-void setup() 
+#if ENABLE_STREAMING
+FrameReceiver g_Receiver(NUM_LEDS);     // Jitter buffer for frames from the show server
+#endif
+
+#if CLOCK_SYNC
+ClockSyncServer g_ClockServer;          // Answers time requests if we're the board the others follow
+ClockSync       g_ClockSync;            // ...or tracks that board's clock if we're not
+#endif
+
+#if SERIAL_INPUT
+SerialFrameReceiver g_SerialInput(NUM_LEDS);    // Frames from a host on the USB serial port
+#endif
+
+NVSConfigStore   g_ConfigStore;
+PersistentConfig g_Config(g_ConfigStore);       // Brings the settings back after a reboot
+
+OLEDDashboard g_Dashboard(g_OLED);              // Frame preview and timing on the OLED, a few tiles a frame
+bool g_bOLEDReady = false;                      // Set once InitOLEDTask has the display up
+PaletteFader g_PaletteFader(vu_SeahawksTable);  // Palette the palettes effect draws from, fading between them
+
+// Local effects
+//
+// The on-board patterns, one function each.  The shell's effect command picks which one runs.
+
+void DrawRGBSpinners(const FrameContext & frame)
 {
-  pinMode(LED_BUILTIN, OUTPUT);
-  pinMode(LED_PIN, OUTPUT);
+  // RGB Spinners
+  float b = frame.Beat16(60) / 65535.0f * FAN_SIZE;
+  DrawFanPixels(b, 1, CRGB::Red, Sequential, 0);
+  DrawFanPixels(b, 1, CRGB::Green, Sequential, 1);
+  DrawFanPixels(b, 1, CRGB::Blue, Sequential, 2);
+}
 
-  Serial.begin(115200);
-  while (!Serial) { }
-  Serial.println("ESP32 Startup");
+void DrawLeftRightWipe(const FrameContext & frame)
+{
+  // Left to Right Cyan Wipe
+  float b = frame.BeatSin16(60) / 65535.0f * FAN_SIZE;
+  for (int iFan = 0; iFan < NUM_FANS; iFan++)
+      DrawFanPixels(0, b, CRGB::Cyan, LeftRight, iFan);
+}
+
+void DrawRightLeftWipe(const FrameContext & frame)
+{
+  // Right to Left Cyan Wipe
+  float b = frame.BeatSin16(60) / 65535.0f * FAN_SIZE;
+  for (int iFan = 0; iFan < NUM_FANS; iFan++)
+      DrawFanPixels(0, b, CRGB::Cyan, RightLeft, iFan);
+}
+
+void DrawBottomUpWipe(const FrameContext & frame)
+{
+  // Bottom up Green Wipe
+  float b = frame.BeatSin16(60) / 65535.0f * NUM_LEDS;
+      DrawFanPixels(0, b, CRGB::Green, BottomUp);
+}
+
+void DrawTopDownWipe(const FrameContext & frame)
+{
+  // Top down Green Wipe
+  float b = frame.BeatSin16(60) / 65535.0f * NUM_LEDS;
+      DrawFanPixels(0, b, CRGB::Green, TopDown);
+}
+
+const IndexedFrame * DrawColorCycle(const FrameContext & frame)
+{
+  // Simple Color Cycle, every pixel the same hue and the hue wheel turning under them
+  static IndexedFrame image(NUM_LEDS, HueWheel());
+  image.Rotate(4);
+  return &image;
+}
+
+const IndexedFrame * DrawSequentialRainbows(const FrameContext & frame)
+{
+  // Sequential Rainbows, drawn once and cycled by turning the hue wheel
+  static IndexedFrame image(NUM_LEDS, HueWheel());
+  static bool bDrawn = (image.FillRamp(16 << 8, 16 << 8), true);
+  image.Rotate(4);
+  return &image;
+}
+
+void DrawVerticalRainbowWipe(const FrameContext & frame)
+{
+  // Vertical Rainbow Wipe
+  static byte basehue = 0;
+  byte hue = basehue;
+  for (int i = 0; i < NUM_LEDS; i++)
+    DrawFanPixels(i, 1, CHSV(hue+=8, 255, 255), BottomUp);
+  basehue += 4;
+}
+
+void DrawHorizontalRainbowStripe(const FrameContext & frame)
+{
+  // Horizontal Rainbow Stripe
+  static byte basehue = 0;
+  byte hue = basehue;
+  for (int i = 0; i < NUM_LEDS; i++)
+    DrawFanPixels(i, 1, CHSV(hue+=16, 255, 255), LeftRight);
+  basehue += 8;
+}
+
+void DrawRainbowStripePalette(const FrameContext & frame)
+{
+  // Rainbow Stripe Palette Effect
+  static CRGBPalette256 pal(RainbowStripeColors_p);
+  static byte baseColor = 0;
+  MapPaletteRamp(pal, (baseColor + 4) << 8, 4 << 8, BottomUp);
+  baseColor += 1;
+}
+
+void DrawVUMeter(const FrameContext & frame)
+{
+  // vu-Style Meter
+  int b = frame.BeatSin16(30) * NUM_LEDS / 65535L;
+  MapPaletteRamp(vu_GreenTable, 0, 255 * 256 / NUM_LEDS, BottomUp, NOBLEND, b);
+}
+
+void DrawSequentialFire(const FrameContext & frame)
+{
+  // Sequential Fire Fans
+  static FireEffect fire(NUM_LEDS, 20, 100, 3, NUM_LEDS, true, false);
+  fire.Tune(g_FireCooling, g_FireSparking);
+  fire.DrawFire(frame);
+}
+
+void DrawBottomUpFire(const FrameContext & frame)
+{
+  // Bottom Up Fire Effect with extra sparking on first fan only
+  static FireEffect fire(NUM_LEDS, 20, 140, 3, FAN_SIZE, true, false);
+  fire.Tune(g_FireCooling, g_FireSparking);
+  fire.DrawFire(frame, BottomUp);
+}
+
+void DrawWideFire(const FrameContext & frame)
+{
+  // LeftRight (Wide) Fire Effect with extra sparking on first fan only
+  static FireEffect fire(NUM_LEDS, 20, 140, 3, FAN_SIZE, true, false);
+  fire.Tune(g_FireCooling, g_FireSparking);
+  fire.DrawFire(frame, LeftRight);
+  for (int i = 0; i < FAN_SIZE; i++)  // Copy end fan down onto others
+  {
+    g_LEDs[i] = g_LEDs[i + 2 * FAN_SIZE];             
+    g_LEDs[i + FAN_SIZE] = g_LEDs[i + 2 * FAN_SIZE];
+  }
+}
+
+void DrawComets(const FrameContext & frame)
+{
+  // Three comets at different speeds with drifting hues
+  static CometEffect comets(NUM_LEDS, 32);
+  static bool bCometsAdded = comets.AddComet(0, 20, HUE_RED, 30, 12)
+                          && comets.AddComet(NUM_LEDS / 3, -12, HUE_GREEN, -20, 8)
+                          && comets.AddComet(NUM_LEDS / 2, 31.5, HUE_BLUE, 60, 20, 2);
+  comets.Draw(frame);
+}
+
+void DrawTwinkleStars(const FrameContext & frame)
+{
+  // Twinkling stars, twenty new ones a second that each last about three seconds
+  static TwinkleEffect twinkle(NUM_LEDS, 20, 3);
+  twinkle.Draw(frame);
+}
+
+void DrawBouncingBalls(const FrameContext & frame)
+{
+  // Bouncing Balls, mirrored in from both ends
+  static BouncingBallEffect balls(NUM_LEDS, 5, 64, true);
+  balls.Draw(frame);
+}
+
+const IndexedFrame * DrawSeahawks(const FrameContext & frame)
+{
+  // Seahawks palette scrolling up the fans
+  static IndexedFrame image(NUM_LEDS, vu_SeahawksTable);
+  static bool bDrawn = (image.FillRamp(0, 255 * 256 / NUM_LEDS, BottomUp), true);
+  image.SetRotation(frame.Beat8(64));
+  return &image;
+}
+
+// FadeToPalette
+//
+// Starts a crossfade to one of the named palettes
+
+const char * const g_PaletteNames[] = { "seahawks", "green", "stripes" };
+const int g_cPalettes = sizeof(g_PaletteNames) / sizeof(g_PaletteNames[0]);
+int g_Palette = 0;
+float g_PaletteSeconds = 3.0f;          // How long each crossfade takes
+
+void FadeToPalette(int index)
+{
+  g_Palette = index;
+  switch (index)
+  {
+    case 0:  g_PaletteFader.FadeTo(vu_SeahawksTable, g_PaletteSeconds); break;
+    case 1:  g_PaletteFader.FadeTo(vu_GreenTable, g_PaletteSeconds); break;
+    default: g_PaletteFader.FadeTo(RainbowStripeColors_p, g_PaletteSeconds); break;
+  }
+}
+
+void DrawPaletteFade(const FrameContext & frame)
+{
+  // Scrolling palette that crossfades to the next one every ten seconds
+  static uint32_t period = frame.Millis() / 10000;
+  if (frame.Millis() / 10000 != period)
+  {
+    period = frame.Millis() / 10000;
+    FadeToPalette((g_Palette + 1) % g_cPalettes);
+  }
+  g_PaletteFader.Update(frame);
+  MapPaletteRamp(g_PaletteFader.Entries(), frame.Beat16(32), 255 * 256 / NUM_LEDS, BottomUp, LINEARBLEND);
+}
+
+// LocalEffect
+//
+// Effects draw either straight into g_LEDs, or into an IndexedFrame that they hand back for the
+// output pass to resolve.  g_LEDs is cleared before each frame unless the effect keeps track of
+// its own pixels from one frame to the next.
+
+struct LocalEffect
+{
+  const char *           Name;
+  void                (* Draw)(const FrameContext & frame);
+  const IndexedFrame * (* DrawIndexed)(const FrameContext & frame);
+  bool                   bKeepsFrame;   // Draws over its own previous frame rather than a cleared one
+};
+
+const LocalEffect g_Effects[] =
+{
+  { "spinners",   DrawRGBSpinners },
+  { "lrwipe",     DrawLeftRightWipe },
+  { "rlwipe",     DrawRightLeftWipe },
+  { "upwipe",     DrawBottomUpWipe },
+  { "downwipe",   DrawTopDownWipe },
+  { "cycle",      nullptr, DrawColorCycle },
+  { "rainbows",   nullptr, DrawSequentialRainbows },
+  { "vrainbow",   DrawVerticalRainbowWipe },
+  { "hrainbow",   DrawHorizontalRainbowStripe },
+  { "stripes",    DrawRainbowStripePalette },
+  { "vu",         DrawVUMeter },
+  { "fire",       DrawSequentialFire },
+  { "upfire",     DrawBottomUpFire },
+  { "widefire",   DrawWideFire },
+  { "comets",     DrawComets },
+  { "twinkle",    DrawTwinkleStars, nullptr, true },
+  { "balls",      DrawBouncingBalls },
+  { "seahawks",   nullptr, DrawSeahawks },
+  { "palettes",   DrawPaletteFade },
+  { "marquee",    DrawMarquee },
+  { "mirrorquee", DrawMarqueeMirrored },
+  { "comet",      DrawComet },
+};
+const int g_cEffects = sizeof(g_Effects) / sizeof(g_Effects[0]);
+const int g_DefaultEffect = 17;         // Seahawks
+int g_Effect = g_DefaultEffect;
+
+// CurrentSettings
+//
+// The live settings, gathered up for saving
+
+FanSettings CurrentSettings()
+{
+  return FanSettings { (uint8_t) g_Brightness, (int8_t) g_Effect, (uint16_t) g_TargetFPS, (uint32_t) g_PowerLimit,
+                       (uint8_t) g_FireCooling, (uint8_t) g_FireSparking };
+}
+
+// DrawLocalEffect
+//
+// Draws one frame of whichever on-board effect is selected.  Returns the indexed frame if that's
+// what the effect drew, for the output pass to resolve.
+
+const IndexedFrame * DrawLocalEffect(const FrameContext & frame)
+{
+  static int      lastEffect = -1;
+  static uint32_t lastFrame  = 0;
+
+  const LocalEffect & effect = g_Effects[g_Effect];
+  bool bContinues = g_Effect == lastEffect && frame.FrameNumber == lastFrame + 1;     // g_LEDs still holds its last frame
+  lastEffect = g_Effect;
+  lastFrame  = frame.FrameNumber;
+
+  if (effect.DrawIndexed)
+    return effect.DrawIndexed(frame);
+
+  if (!effect.bKeepsFrame || !bContinues)
+    fill_solid(g_LEDs, NUM_LEDS, CRGB::Black);         // Not FastLED.clear(), which clears the buffer being sent
+  effect.Draw(frame);
+  return nullptr;
+}
+
+#if !SERIAL_INPUT
+
+// Shell commands
+//
+// Each runs from CommandShell::Poll() at the top of the frame loop, so whatever it changes takes
+// effect from the next frame on
+
+void EffectCommand(int argc, char * argv[])
+{
+  if (argc > 1)
+  {
+    long index = -1;
+    if (!ParseInt(argv[1], 0, g_cEffects - 1, index))
+    {
+      index = -1;
+      for (int i = 0; i < g_cEffects; i++)
+        if (!strcmp(argv[1], g_Effects[i].Name))
+          index = i;
+    }
+    if (index < 0)
+    {
+      Serial.printf("No effect '%s'\n", argv[1]);
+      return;
+    }
+    g_Effect = index;
+  }
+  for (int i = 0; i < g_cEffects; i++)
+    Serial.printf("%c %2d %s\n", i == g_Effect ? '*' : ' ', i, g_Effects[i].Name);
+}
+
+void BrightCommand(int argc, char * argv[])
+{
+  long value;
+  if (argc > 1)
+  {
+    if (!ParseInt(argv[1], 0, 255, value))
+    {
+      Serial.println("bright takes 0-255");
+      return;
+    }
+    g_Brightness = value;
+  }
+  Serial.printf("Brightness %d requested, %d after power limiting\n", g_Brightness, g_Output.Brightness());
+}
+
+void PowerCommand(int argc, char * argv[])
+{
+  long value;
+  if (argc > 1)
+  {
+    if (!ParseInt(argv[1], 0, 100000, value))
+    {
+      Serial.println("power takes a limit in mW, 0 for none");
+      return;
+    }
+    g_PowerLimit = value;
+    g_Output.SetPowerLimit(g_PowerLimit);
+  }
+  Serial.printf("Power limit %d mW, drawing %u mW (%u unscaled)\n", g_PowerLimit, g_Output.PowerMilliwatts(), g_Output.UnscaledPowerMilliwatts());
+}
+
+void FpsCommand(int argc, char * argv[])
+{
+  long value;
+  if (argc > 1)
+  {
+    if (!ParseInt(argv[1], 0, 1000, value))
+    {
+      Serial.println("fps takes a target frame rate, 0 to run flat out");
+      return;
+    }
+    g_TargetFPS = value;
+  }
+  Serial.printf("Target %d FPS, running at %u\n", g_TargetFPS, FastLED.getFPS());
+}
+
+void FireCommand(int argc, char * argv[])
+{
+  long cooling = 0, sparking = 0;
+  if (argc < 2 || !ParseInt(argv[1], 0, 255, cooling) || (argc > 2 && !ParseInt(argv[2], 0, 255, sparking)))
+  {
+    Serial.println("fire takes cooling and optionally sparking, 1-255 each or 0 for the effects' own");
+    return;
+  }
+  g_FireCooling  = cooling;
+  g_FireSparking = sparking;
+}
+
+void PaletteCommand(int argc, char * argv[])
+{
+  long index = -1, tenths = 0;
+  if (argc > 1 && !ParseInt(argv[1], 0, g_cPalettes - 1, index))
+    for (int i = 0; i < g_cPalettes; i++)
+      if (!strcmp(argv[1], g_PaletteNames[i]))
+        index = i;
+  if ((argc > 1 && index < 0) || (argc > 2 && !ParseInt(argv[2], 0, 600, tenths)))
+  {
+    Serial.println("palette takes a name or number, and optionally a fade time in tenths of a second");
+    return;
+  }
+  if (argc > 2)
+    g_PaletteSeconds = tenths / 10.0f;
+  if (argc > 1)
+    FadeToPalette(index);
+  for (int i = 0; i < g_cPalettes; i++)
+    Serial.printf("%c %d %s\n", i == g_Palette ? '*' : ' ', i, g_PaletteNames[i]);
+  Serial.printf("Crossfades take %.1f s%s\n", g_PaletteSeconds, g_PaletteFader.IsFading() ? ", one in progress" : "");
+}
+
+void StatsCommand(int argc, char * argv[])
+{
+  Serial.printf("Effect %s, %u FPS, frame %u\n", g_Effects[g_Effect].Name, FastLED.getFPS(), g_FrameClock.Current().FrameNumber);
+  Serial.printf("Output: %u shown, %u skipped, %u late, pass %u us, show %u us\n",
+                g_Output.ShownFrames(), g_Output.SkippedFrames(), g_Output.LateFrames(), g_Output.PassMicros(), g_Output.ShowDurationMicros());
+  Serial.printf("Power: %u/%u mW, brightness %d of %d\n",
+                g_Output.PowerMilliwatts(), g_Output.UnscaledPowerMilliwatts(), g_Output.Brightness(), g_Brightness);
+  Serial.printf("Segments: %u, sum %u us of the pass, scaling %u us\n",
+                g_Output.PowerSegments(), g_Output.SumMicros(), g_Output.ScaleMicros());
+  Serial.printf("OLED: %u byte buffer, %u tiles sent, worst update %u us, last picture %u us\n", g_Dashboard.BufferBytes(),
+                g_Dashboard.TilesSent(), g_Dashboard.WorstMicros(), g_Dashboard.RefreshMicros());
+  Serial.printf("Shell: idle poll %u us worst; settings %s, %u writes\n", g_ShellIdleMicros,
+                g_Config.IsDirty() ? "waiting to save" : "saved", g_Config.Writes());
+#if ENABLE_STREAMING
+  Serial.printf("Stream: %u shown, %u late, %u dropped, %u duplicate\n",
+                g_Receiver.PresentedFrames(), g_Receiver.LateFrames(), g_Receiver.DroppedFrames(), g_Receiver.DuplicateFrames());
+#endif
+}
+
+void BenchCommand(int argc, char * argv[])
+{
+  // The benches below draw into g_LEDs, so keep the live frame to put back at the end.  Twinkle
+  // draws over its own last frame, and would otherwise carry on from a bench picture.
+
+  CRGB * pLive = new CRGB[NUM_LEDS];
+  memcpy((void *) pLive, (const void *) g_LEDs, sizeof(g_LEDs));
+
+  // The fans, then a 1024 LED strip with thousands of particles; 60 FPS leaves 16.7ms a frame
+
+  const size_t lengths[] = { NUM_LEDS, 1024 };
+  const size_t counts[]  = { 256, 1024, 4096 };
+  for (size_t cLeds : lengths)
+    for (size_t count : counts)
+    {
+      float rate = BenchmarkParticles(count, cLeds);
+      Serial.printf("Particles: %4u on %4u LEDs, %.0f particles/ms, %.2f ms/frame\n", count, cLeds, rate, rate ? count / rate : 0.0f);
+    }
+
+  PaletteMapStats map = BenchmarkPaletteMap();
+  Serial.printf("Palette: per LED %.1f us, flash table %.1f us, bulk %.1f us, bulk blended %.1f us%s\n", map.PerPixelMicros,
+                map.TableMicros, map.BulkMicros, map.BulkBlendMicros, map.bMatches ? "" : ", BULK MISMATCH");
+
+  // What the power segments add to the output pass, against walking the strip as one run
+
+  SegmentCost segments = g_Output.BenchmarkSegments();
+  Serial.printf("Segments: %u, sum %.1f us whole, %.1f us split (+%.1f us), scaling %.1f us\n", g_Output.PowerSegments(),
+                segments.WholeMicros, segments.SegmentedMicros, segments.SegmentedMicros - segments.WholeMicros, segments.ScaleMicros);
 
+  // A full repaint of the OLED in whichever buffer mode it was built with; OLED_PAGE_BUFFER picks
+
+  if (__atomic_load_n(&g_bOLEDReady, __ATOMIC_ACQUIRE))
+    Serial.printf("OLED: %u byte buffer, full refresh %.0f us\n", g_Dashboard.BufferBytes(),
+                  g_Dashboard.BenchmarkRefresh(g_LEDs, NUM_LEDS, "bench"));
+
+  // Record a couple of seconds of noisy, sparse and busy content at 60 FPS and run each through the
+  // codec.  The effects are instances of their own rather than the ones on the LEDs, so drawing two
+  // seconds ahead doesn't move the live effect along.
+
+  const size_t cFrames = 120;
+  uint8_t * pFrames = new uint8_t[cFrames * sizeof(g_LEDs)];
+
+  FireEffect    fire(NUM_LEDS, 20, 100, 3, NUM_LEDS, true, false);
+  CometEffect   comets(NUM_LEDS, 32);
+  MarqueeEffect marquee;
+  comets.AddComet(0, 20, HUE_RED, 30, 12);
+  comets.AddComet(NUM_LEDS / 2, 31.5, HUE_BLUE, 60, 20, 2);
+
+  const char * const names[] = { "fire", "comets", "marquee" };
+  for (int e = 0; e < 3; e++)
+  {
+    FastRandom random(1);
+    FrameContext frame { g_FrameClock.Current().Micros, 16667, 0, random, g_FrameClock.Current().LocalMicros };
+    for (size_t i = 0; i < cFrames; i++)
+    {
+      fill_solid(g_LEDs, NUM_LEDS, CRGB::Black);
+      switch (e)
+      {
+        case 0:  fire.DrawFire(frame); break;
+        case 1:  comets.Draw(frame);   break;
+        default: marquee.Draw(frame);  break;
+      }
+      memcpy(pFrames + i * sizeof(g_LEDs), g_LEDs, sizeof(g_LEDs));
+      frame.Micros += frame.DeltaMicros;
+      frame.FrameNumber++;
+    }
+    CodecStats stats = BenchmarkFrameCodec(pFrames, cFrames, sizeof(g_LEDs), esp_timer_get_time);
+    Serial.printf("Codec: %s %.2fx, encode %.2f MB/s, decode %.2f MB/s%s\n", names[e],
+                  stats.Ratio, stats.EncodeMBps, stats.DecodeMBps, stats.bRoundTrip ? "" : ", ROUND TRIP FAILED");
+  }
+  delete [] pFrames;
+
+  memcpy((void *) g_LEDs, (const void *) pLive, sizeof(g_LEDs));
+  delete [] pLive;
+}
+
+void SaveCommand(int argc, char * argv[])
+{
+  int64_t now = esp_timer_get_time();
+  bool bSaved = g_Config.Update(CurrentSettings(), now) || g_Config.Flush(now);
+  Serial.println(bSaved ? "Saved" : "Nothing to save");
+}
+
+const ShellCommand g_Commands[] =
+{
+  { "effect",  "[name|number]  List effects, or pick one",               EffectCommand },
+  { "bright",  "[0-255]  Show or set brightness",                        BrightCommand },
+  { "power",   "[mW]  Show or set the power limit",                      PowerCommand },
+  { "fps",     "[n]  Show or set the target frame rate",                 FpsCommand },
+  { "fire",    "cooling [sparking]  Tune the fire effects",              FireCommand },
+  { "palette", "[name|number] [tenths]  Crossfade the palettes effect",  PaletteCommand },
+  { "stats",   "Frame, output and power counters",                       StatsCommand },
+  { "bench",   "Time particles, palettes, OLED, codec (stalls output)",   BenchCommand },
+  { "save",    "Save settings now rather than when they settle",         SaveCommand },
+};
+
+CommandShell g_Shell(g_Commands, sizeof(g_Commands) / sizeof(g_Commands[0]));
+
+#endif
+
+// InitOLEDTask
+//
+// Bringing the OLED up over I2C takes longer than everything else in setup put together, so it's
+// done in a task on core 0, away from both the render loop and LED output on core 1, while the
+// LEDs get going.  The status display starts once it's ready.
+
+void InitOLEDTask(void *)
+{
+  g_OLED.setBusClock(OLED_I2C_HZ);
   g_OLED.begin();
   g_OLED.clear();
-  g_OLED.setFont(u8g2_font_profont15_tf);
-  g_lineHeight = g_OLED.getFontAscent() - g_OLED.getFontDescent();        // Descent is a negative number so we add it to the total
+  __atomic_store_n(&g_bOLEDReady, true, __ATOMIC_RELEASE);
+  vTaskDelete(nullptr);
+}
 
-  FastLED.addLeds<WS2812B, LED_PIN, GRB>(g_LEDs, NUM_LEDS);               // Add our LED strip to the FastLED library
+// setup
+//
+// Ordered to get a first frame onto the LEDs as soon as possible: saved settings, then FastLED,
+// then one frame, and only then the slower things (serial, OLED, WiFi)
+
+void setup() 
+{
+  FanSettings settings = CurrentSettings();                               // Compiled-in values are the defaults...
+  g_Config.Load(settings);                                                // ...unless we saved something last time
+  g_Brightness   = settings.Brightness;
+  g_Effect       = settings.Effect >= 0 && settings.Effect < g_cEffects ? settings.Effect : g_DefaultEffect;
+  g_TargetFPS    = settings.TargetFPS;
+  g_PowerLimit   = settings.PowerLimit;
+  g_FireCooling  = settings.FireCooling;
+  g_FireSparking = settings.FireSparking;
+
+  CRGB * pOutput = g_Output.Begin(OUTPUT_CORE);                           // Buffer FastLED sends from; g_LEDs unless there's an output task
+#if PARALLEL_OUTPUT
+  float maxFPS = ParallelOutput<LED_PINS>::Add(pOutput, NUM_LEDS);        // Split the strip across several pins
+#else
+  float maxFPS = ParallelOutput<LED_PIN>::Add(pOutput, NUM_LEDS);         // Add our LED strip to the FastLED library
+#endif
+  g_Output.SetExpectedShowMicros(1000000 / maxFPS);                       // Frames that take much longer than this count as late
   FastLED.setBrightness(g_Brightness);
-  set_max_power_indicator_LED(LED_BUILTIN);                               // Light the builtin LED if we power throttle
-  FastLED.setMaxPowerInMilliWatts(g_PowerLimit);                          // Set the power limit, above which brightness will be throttled
+  g_Output.SetPowerLimit(g_PowerLimit);                                   // Set the power limit, above which brightness will be throttled
+  for (int i = 0; g_FanPowerLimit && i < NUM_FANS; i++)
+    g_Output.AddPowerSegment(i * FAN_SIZE, FAN_SIZE, g_FanPowerLimit);      // ...and limit each fan to what its own supply can give
+
+  const FrameContext & frame = g_FrameClock.BeginFrame();                 // First frame goes out before anything else
+  g_Output.Show(frame, g_Brightness, DrawLocalEffect(frame));             // With an output task, this only queues it
+
+  xTaskCreatePinnedToCore(InitOLEDTask, "OLED Init", 4096, nullptr, 1, nullptr, 0);
+
+  pinMode(LED_BUILTIN, OUTPUT);
+
+#if SERIAL_INPUT
+  g_SerialInput.Start(SERIAL_BAUD, 0);                                    // Opens Serial itself, with a big receive buffer
+#else
+  Serial.begin(115200);                                                   // Doesn't wait for a host to be listening
+#endif
+  Serial.println("ESP32 Startup");
+  while (!g_Output.FirstShowMicros())                                     // Long done by now, unless the output task is still sending it
+    delay(1);
+  Serial.printf("First frame %.1f ms after boot\n", g_Output.FirstShowMicros() / 1000.0f);
+  Serial.printf("Wire time allows at most %.0f FPS\n", maxFPS);
+
+#if OUTPUT_STRESS_TEST
+  StartOutputStressLoad(OUTPUT_CORE < 0 ? xPortGetCoreID() : OUTPUT_CORE, 100, 20);  // 20uS of every 100uS spent in an ISR
+#endif
+
+#if ENABLE_STREAMING || CLOCK_SYNC
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);                                   // Connects in the background
+#endif
+#if ENABLE_STREAMING
+  g_Receiver.Start(FrameReceiver::DefaultPort, 0);                        // Receive on core 0 with the network stack, away from LED output
+#endif
+#if CLOCK_SYNC
+  if (CLOCK_SERVER[0])
+  {
+    g_ClockSync.Start(CLOCK_SERVER);                                      // Requests keep failing quietly until WiFi is up
+    g_FrameClock.SetTimeSource(&g_ClockSync);                             // Effects now run on the shared timebase
+  }
+  else
+  {
+    g_ClockServer.Start();
+  }
+#endif
 }
 
 void loop() 
@@ -70,137 +694,74 @@ void loop()
 
   while (true)
   {
-    FastLED.clear();
-   
-    /*
-    // RGB Spinners
-    float b = beat16(60) / 65535.0f * FAN_SIZE;
-    DrawFanPixels(b, 1, CRGB::Red, Sequential, 0);
-    DrawFanPixels(b, 1, CRGB::Green, Sequential, 1);
-    DrawFanPixels(b, 1, CRGB::Blue, Sequential, 2);
-    */
-
-    /*
-    // Left to Right Cyan Wipe
-    float b = beatsin16(60) / 65535.0f * FAN_SIZE;
-    for (int iFan = 0; iFan < NUM_FANS; iFan++)
-        DrawFanPixels(0, b, CRGB::Cyan, LeftRight, iFan);
-    */
-
-    /*
-    // Left to Right Cyan Wipe
-    float b = beatsin16(60) / 65535.0f * FAN_SIZE;
-    for (int iFan = 0; iFan < NUM_FANS; iFan++)
-        DrawFanPixels(0, b, CRGB::Cyan, RightLeft, iFan);
-    */
-
-    /*
-    // Bottom up Green Wipe
-    float b = beatsin16(60) / 65535.0f * NUM_LEDS;
-        DrawFanPixels(0, b, CRGB::Green, BottomUp);
-    */
-   
-    /*
-    // Bottom up Green Wipe
-    float b = beatsin16(60) / 65535.0f * NUM_LEDS;
-        DrawFanPixels(0, b, CRGB::Green, TopDown);
-    */
-
-    /*
-    // Simple Color Cycle
-    static byte hue = 0;
-    for (int i = 0; i < NUM_LEDS; i++)
-      DrawFanPixels(i, 1, CHSV(hue, 255, 255));
-    hue += 4;
-    */
-
-    /*
-    // Sequential Rainbows
-    static byte basehue = 0;
-    byte hue = basehue;
-    for (int i = 0; i < NUM_LEDS; i++)
-      DrawFanPixels(i, 1, CHSV(hue+=16, 255, 255));
-    basehue += 4;
-    */
-
-    /*
-    // Vertical Rainbow Wipe
-    static byte basehue = 0;
-    byte hue = basehue;
-    for (int i = 0; i < NUM_LEDS; i++)
-      DrawFanPixels(i, 1, CHSV(hue+=8, 255, 255), BottomUp);
-    basehue += 4;
-    */
-
-    /*
-    // Horizontal Rainbow Stripe
-    static byte basehue = 0;
-    byte hue = basehue;
-    for (int i = 0; i < NUM_LEDS; i++)
-      DrawFanPixels(i, 1, CHSV(hue+=16, 255, 255), LeftRight);
-    basehue += 8;
-    */
-
-    /*
-    // Rainbow Stripe Palette Effect
-    static CRGBPalette256 pal(RainbowStripeColors_p);
-    static byte baseColor = 0;
-    byte hue = baseColor;
-    for (int i = 0; i < NUM_LEDS; i++)
-      DrawFanPixels(i, 1, ColorFromPalette(pal, hue += 4), BottomUp);
-    baseColor += 1;
-    */
-
-    /*   
-    // vu-Style Meter
-    int b = beatsin16(30) * NUM_LEDS / 65535L;
-    static const CRGBPalette256 vuPaletteGreen = vu_gpGreen;
-    for (int i = 0; i < b; i++)
-        DrawFanPixels(i, 1, ColorFromPalette(vuPaletteGreen, (int)(255 * i / NUM_LEDS)), BottomUp);
-    */
-
-    /*
-    // Sequential Fire Fans
-    static FireEffect fire(NUM_LEDS, 20, 100, 3, NUM_LEDS, true, false);
-    fire.DrawFire();
-    */
-
-    /*
-    // Bottom Up Fire Effect with extra sparking on first fan only
-    static FireEffect fire(NUM_LEDS, 20, 140, 3, FAN_SIZE, true, false);
-    fire.DrawFire(BottomUp);
-    */
-
-    /*
-    // LeftRight (Wide) Fire Effect with extra sparking on first fan only
-    static FireEffect fire(NUM_LEDS, 20, 140, 3, FAN_SIZE, true, false);
-    fire.DrawFire(LeftRight);
-    for (int i = 0; i < FAN_SIZE; i++)  // Copy end fan down onto others
+#if !SERIAL_INPUT
+    int64_t shellStart = esp_timer_get_time();
+    if (!g_Shell.Poll())                                  // Commands apply between frames
+      g_ShellIdleMicros = max(g_ShellIdleMicros, (uint32_t)(esp_timer_get_time() - shellStart));
+#endif
+
+    const FrameContext & frame = g_FrameClock.BeginFrame();
+    const IndexedFrame * pIndexed = nullptr;                // Set if the effect drew palette indices
+
+#if SERIAL_INPUT
+    if (g_SerialInput.IsStreaming(frame.LocalMicros))
+      g_SerialInput.Present(g_LEDs);                      // A host on the serial port takes priority
+    else
+#endif
+#if ENABLE_STREAMING
+    if (g_Receiver.IsStreaming(frame.LocalMicros))
+      g_Receiver.Present(frame.LocalMicros, g_LEDs);         // Streamed frames replace the local effects
+    else
+#endif
+      pIndexed = DrawLocalEffect(frame);
+
+    int64_t showStart = esp_timer_get_time();
+    g_Output.Show(frame, g_Brightness, pIndexed);        //  Show (if anything changed) and delay
+    int64_t showEnd = esp_timer_get_time();
+    digitalWrite(LED_BUILTIN, g_Output.IsThrottled(g_Brightness));    // Light the builtin LED if we power throttle
+    g_Config.Update(CurrentSettings(), frame.LocalMicros);            // Saves changes once they've settled
+
+    if (__atomic_load_n(&g_bOLEDReady, __ATOMIC_ACQUIRE))
     {
-      g_LEDs[i] = g_LEDs[i + 2 * FAN_SIZE];             
-      g_LEDs[i + FAN_SIZE] = g_LEDs[i + 2 * FAN_SIZE];
+      char status[32];
+      snprintf(status, sizeof(status), "%ufps %umW b%d late %u", FastLED.getFPS(), g_Output.PowerMilliwatts(),
+               g_Output.Brightness(), g_Output.LateFrames());
+      g_Dashboard.Update(g_LEDs, NUM_LEDS, status);      // A few changed tiles, or one band of them, a frame
     }
-    */
-
-    int b = beatsin16(30) * NUM_LEDS / 65535L;
-    static const CRGBPalette256 seawhawksPalette = vu_gpSeahawks;
-    for (int i = 0; i < NUM_LEDS; i++)
-        DrawFanPixels(i, 1, ColorFromPalette(seawhawksPalette, beat8(64) + (int)(255 * i / NUM_LEDS)), BottomUp);
-    
-    
-    FastLED.show(g_Brightness);                          //  Show and delay
+#if ENABLE_STREAMING
+    EVERY_N_SECONDS(5)
+    {
+      Serial.printf("Stream: %u shown, %u late, %u dropped, %u duplicate\n",
+                    g_Receiver.PresentedFrames(), g_Receiver.LateFrames(), g_Receiver.DroppedFrames(), g_Receiver.DuplicateFrames());
+    }
+#endif
+#if CLOCK_SYNC
+    EVERY_N_SECONDS(5)
+    {
+      if (CLOCK_SERVER[0])
+        Serial.printf("Clock: %s, phase error ~%.0f us, drift %+.1f ppm, rtt %u us, %u samples, %u rejected\n",
+                      g_ClockSync.IsSynchronized(frame.LocalMicros) ? "synced" : "not synced", g_ClockSync.PhaseErrorMicros(),
+                      g_ClockSync.DriftPPM(), g_ClockSync.RoundTripMicros(), g_ClockSync.Samples(), g_ClockSync.Rejected());
+      else
+        Serial.printf("Clock: serving, %u requests\n", g_ClockServer.Requests());
+    }
+#endif
+#if SERIAL_INPUT
+    EVERY_N_SECONDS(5)
+    {
+      Serial.printf("Serial: %u shown, %u overwritten, %u bad CRC, %u bad header, %u awaiting keyframe\n",
+                    g_SerialInput.PresentedFrames(), g_SerialInput.OverwrittenFrames(), g_SerialInput.CrcErrors(),
+                    g_SerialInput.BadHeaders(), g_SerialInput.WaitingForKey());
+    }
+#endif
 
-    EVERY_N_MILLISECONDS(250)
+    int64_t idleStart = esp_timer_get_time();
+    if (g_TargetFPS)                                      // Sleep off whatever's left of this frame's slot
     {
-      g_OLED.clearBuffer();
-      g_OLED.setCursor(0, g_lineHeight);
-      g_OLED.printf("FPS  : %u", FastLED.getFPS());
-      g_OLED.setCursor(0, g_lineHeight * 2);
-      g_OLED.printf("Power: %u mW", calculate_unscaled_power_mW(g_LEDs, 4));
-      g_OLED.setCursor(0, g_lineHeight * 3);
-      g_OLED.printf("Brite: %d", calculate_max_brightness_for_power_mW(g_Brightness, g_PowerLimit));
-      g_OLED.sendBuffer();
+      int64_t remaining = 1000000 / g_TargetFPS - (idleStart - (int64_t) frame.LocalMicros);
+      if (remaining >= 1000)
+        delay(remaining / 1000);
     }
-    delay(33);
+    g_Dashboard.AddSample(showStart - frame.LocalMicros, showEnd - showStart, esp_timer_get_time() - idleStart);
   }
 }
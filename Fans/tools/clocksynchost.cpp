@@ -0,0 +1,109 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        clocksynchost.cpp
+//
+// Description:
+//
+//   Runs the firmware's clock sync on the host.  Each client simulates a
+//   board whose clock is offset and runs fast or slow, and since every
+//   process on the host really shares one clock, it can report how far its
+//   synchronized time is from the server's - the skew the fans would see.
+//
+//      g++ -O2 -I../include clocksynchost.cpp -o clocksynchost
+//      ./clocksynchost server &
+//      ./clocksynchost client 1234 80 30 &          1.234s ahead, 80ppm fast, 30 seconds
+//      ./clocksynchost client -5000 -120 30 &
+//      ./clocksynchost client 0 40 30
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "clocksync.h"
+
+static int64_t g_offsetMicros = 0;
+static double  g_rate = 1.0;
+static int64_t g_start = 0;
+
+// The simulated board's clock for a given true (server) time
+
+static int64_t SimulatedFrom(int64_t real)
+{
+    return g_start + (int64_t)((real - g_start) * g_rate) + g_offsetMicros;
+}
+
+static int64_t SimulatedClock()
+{
+    return SimulatedFrom(esp_timer_get_time());
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc >= 2 && !strcmp(argv[1], "server"))
+    {
+        ClockSyncServer server;
+        if (!server.Open(argc > 2 ? atoi(argv[2]) : ClockSyncPort))
+        {
+            perror("open");
+            return 1;
+        }
+        for (;;)
+            server.Service();
+    }
+
+    if (argc < 4 || strcmp(argv[1], "client"))
+    {
+        fprintf(stderr, "usage: %s server [port] | client <offsetMillis> <ppm> [seconds] [server] [port]\n", argv[0]);
+        return 1;
+    }
+
+    g_start        = esp_timer_get_time();
+    g_offsetMicros = (int64_t) atoi(argv[2]) * 1000;
+    g_rate         = 1.0 + atof(argv[3]) / 1000000.0;
+    int seconds    = argc > 4 ? atoi(argv[4]) : 30;
+
+    ClockSync sync(SimulatedClock);
+    if (!sync.Open(argc > 5 ? argv[5] : "127.0.0.1", argc > 6 ? atoi(argv[6]) : ClockSyncPort))
+    {
+        perror("open");
+        return 1;
+    }
+
+    // Skew is measured over the second half of the run, once the loop has settled
+
+    int64_t end = g_start + (int64_t) seconds * 1000000, nextReport = g_start + 1000000;
+    double  sumSquares = 0, worst = 0;
+    int     cMeasured = 0;
+
+    for (int64_t real = g_start; real < end; real = esp_timer_get_time())
+    {
+        sync.Service();
+
+        real = esp_timer_get_time();
+        double skew = (double)(sync.SharedMicros(SimulatedFrom(real)) - real);
+        if (real - g_start > (end - g_start) / 2)
+        {
+            sumSquares += skew * skew;
+            worst       = fmax(worst, fabs(skew));
+            cMeasured++;
+        }
+
+        if (real >= nextReport)
+        {
+            printf("%3ds  skew %+8.0f us  drift %+7.1f ppm  phase err %5.0f us  rtt %4u us  samples %u rejected %u\n",
+                   (int)((real - g_start) / 1000000), skew, sync.DriftPPM(), sync.PhaseErrorMicros(),
+                   sync.RoundTripMicros(), sync.Samples(), sync.Rejected());
+            nextReport += 1000000;
+        }
+    }
+
+    printf("skew over the last %ds: rms %.1f us, worst %.1f us\n", seconds / 2, sqrt(sumSquares / (cMeasured ? cMeasured : 1)), worst);
+    return 0;
+}
@@ -0,0 +1,213 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        codecbench.cpp
+//
+// Description:
+//
+//   Host benchmark for the frame codec: encode and decode throughput and
+//   compression ratio.  Reads a raw capture (frames of RGB back to back) if
+//   given one, otherwise renders host versions of the fire, twinkle, comet
+//   and marquee effects.
+//
+//      g++ -O2 -I../include codecbench.cpp -o codecbench
+//      ./codecbench                     Built-in effects, 144 LEDs, 600 frames each
+//      ./codecbench capture.rgb 144     A capture of 144-LED frames
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "framecodec.h"
+
+static int64_t HostMicros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t g_seed = 1;
+
+static uint32_t Random(uint32_t limit)
+{
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 17;
+    g_seed ^= g_seed << 5;
+    return g_seed % limit;
+}
+
+static void SetHue(uint8_t * p, uint8_t hue, uint8_t value)
+{
+    // Cheap three-segment hue wheel, close enough to CHSV for compression purposes
+
+    uint8_t r, g, b, x = (hue % 85) * 3;
+    if (hue < 85)       { r = 255 - x; g = x;       b = 0;       }
+    else if (hue < 170) { r = 0;       g = 255 - x; b = x;       }
+    else                { r = x;       g = 0;       b = 255 - x; }
+    p[0] = r * value / 255;
+    p[1] = g * value / 255;
+    p[2] = b * value / 255;
+}
+
+// Same shape as FireEffect: heat cools, drifts up, sparks at the base, heat-colour palette
+
+static void RenderFire(uint8_t * pFrames, size_t cFrames, size_t cLeds)
+{
+    uint8_t * heat = new uint8_t[cLeds]();
+    for (size_t f = 0; f < cFrames; f++)
+    {
+        for (size_t i = 0; i < cLeds; i++)
+            heat[i] = heat[i] > 4 ? heat[i] - Random(5) : 0;
+        for (size_t i = cLeds - 1; i >= 2; i--)
+            heat[i] = (heat[i - 1] + 2 * heat[i - 2]) / 3;
+        if (Random(100) < 50)
+        {
+            size_t y = Random(5);
+            heat[y] = heat[y] + 160 + Random(95) > 255 ? 255 : heat[y] + 160 + Random(95);
+        }
+
+        uint8_t * p = pFrames + f * cLeds * 3;
+        for (size_t i = 0; i < cLeds; i++)
+        {
+            uint8_t t = heat[i] * 191 / 255, ramp = (t & 0x3F) << 2;
+            p[i * 3 + 0] = t > 0x40 ? 255 : ramp;
+            p[i * 3 + 1] = t > 0x80 ? 255 : t > 0x40 ? ramp : 0;
+            p[i * 3 + 2] = t > 0x80 ? ramp : 0;
+        }
+    }
+    delete [] heat;
+}
+
+// Sparse stars that fade in and out on black, like TwinkleEffect
+
+static void RenderTwinkle(uint8_t * pFrames, size_t cFrames, size_t cLeds)
+{
+    const int MaxStars = 16;
+    int  pos[MaxStars], age[MaxStars];
+    uint8_t hue[MaxStars];
+    for (int s = 0; s < MaxStars; s++)
+        age[s] = -1;
+
+    for (size_t f = 0; f < cFrames; f++)
+    {
+        uint8_t * p = pFrames + f * cLeds * 3;
+        memset(p, 0, cLeds * 3);
+        for (int s = 0; s < MaxStars; s++)
+        {
+            if (age[s] < 0 && Random(100) < 8)
+            {
+                pos[s] = Random(cLeds);
+                hue[s] = Random(256);
+                age[s] = 0;
+            }
+            if (age[s] < 0)
+                continue;
+            int life = 120, fade = age[s] < 15 ? age[s] * 255 / 15 : (life - age[s]) * 255 / (life - 15);
+            SetHue(p + pos[s] * 3, hue[s], fade);
+            if (++age[s] >= life)
+                age[s] = -1;
+        }
+    }
+}
+
+// A few comets with exponential tails, like CometEffect
+
+static void RenderComets(uint8_t * pFrames, size_t cFrames, size_t cLeds)
+{
+    const int cComets = 3;
+    float pos[cComets] = { 0, cLeds / 3.0f, cLeds * 2 / 3.0f }, speed[cComets] = { 0.7f, -0.45f, 0.3f };
+    for (size_t f = 0; f < cFrames; f++)
+    {
+        uint8_t * p = pFrames + f * cLeds * 3;
+        memset(p, 0, cLeds * 3);
+        for (int c = 0; c < cComets; c++)
+        {
+            pos[c] = fmodf(pos[c] + speed[c] + cLeds, cLeds);
+            for (int t = 0; t < 20; t++)
+            {
+                int i = ((int) pos[c] - (speed[c] > 0 ? t : -t) + cLeds) % cLeds;
+                SetHue(p + i * 3, c * 80 + f / 4, 255 * expf(-t / 5.0f));
+            }
+        }
+    }
+}
+
+// Scrolling rainbow with every fifth pixel dark, like MarqueeEffect
+
+static void RenderMarquee(uint8_t * pFrames, size_t cFrames, size_t cLeds)
+{
+    for (size_t f = 0; f < cFrames; f++)
+    {
+        uint8_t * p = pFrames + f * cLeds * 3;
+        size_t offset = f / 3;
+        for (size_t i = 0; i < cLeds; i++)
+        {
+            size_t k = (i + 160 - offset % 160) % 160;
+            SetHue(p + i * 3, k * 8, k % 5 ? 255 : 0);
+        }
+    }
+}
+
+static void Report(const char * name, const uint8_t * pFrames, size_t cFrames, size_t cLeds)
+{
+    CodecStats stats = BenchmarkFrameCodec(pFrames, cFrames, cLeds * 3, HostMicros);
+    printf("%-10s %6zu frames  %8.2fx  %7zu bytes  encode %8.1f MB/s  decode %8.1f MB/s  %s\n",
+           name, cFrames, stats.Ratio, stats.EncodedBytes, stats.EncodeMBps, stats.DecodeMBps,
+           stats.bRoundTrip ? "ok" : "MISMATCH");
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc == 3)
+    {
+        size_t cLeds = atoi(argv[2]);
+        FILE * f = fopen(argv[1], "rb");
+        if (!f || cLeds == 0)
+        {
+            fprintf(stderr, "can't read %s\n", argv[1]);
+            return 1;
+        }
+        fseek(f, 0, SEEK_END);
+        size_t cFrames = ftell(f) / (cLeds * 3);
+        fseek(f, 0, SEEK_SET);
+        uint8_t * pFrames = new uint8_t[cFrames * cLeds * 3];
+        cFrames = fread(pFrames, cLeds * 3, cFrames, f);
+        fclose(f);
+        Report(argv[1], pFrames, cFrames, cLeds);
+        delete [] pFrames;
+        return 0;
+    }
+    if (argc != 1)
+    {
+        fprintf(stderr, "usage: %s [capture.rgb leds]\n", argv[0]);
+        return 1;
+    }
+
+    const size_t cLeds = 144, cFrames = 600;
+    uint8_t * pFrames = new uint8_t[cFrames * cLeds * 3];
+
+    RenderFire(pFrames, cFrames, cLeds);
+    Report("fire", pFrames, cFrames, cLeds);
+    RenderTwinkle(pFrames, cFrames, cLeds);
+    Report("twinkle", pFrames, cFrames, cLeds);
+    RenderComets(pFrames, cFrames, cLeds);
+    Report("comets", pFrames, cFrames, cLeds);
+    RenderMarquee(pFrames, cFrames, cLeds);
+    Report("marquee", pFrames, cFrames, cLeds);
+
+    for (size_t i = 0; i < cFrames * cLeds * 3; i++)
+        pFrames[i] = Random(256);
+    Report("noise", pFrames, cFrames, cLeds);
+
+    delete [] pFrames;
+    return 0;
+}
@@ -0,0 +1,89 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        confighost.cpp
+//
+// Description:
+//
+//   Exercises the persistent settings on the host against a file standing in
+//   for NVS: simulates an evening of someone fiddling with the shell, reports
+//   how many flash writes that cost, then checks the last state comes back
+//   and that a damaged block falls back to the defaults.
+//
+//      g++ -O2 -I../include confighost.cpp -o confighost
+//      ./confighost /tmp/settings.bin
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+static const FanSettings Defaults = { 255, -1, 30, 3000, 0, 0 };
+
+int main(int argc, char * argv[])
+{
+    const char * path = argc > 1 ? argv[1] : "settings.bin";
+    remove(path);
+
+    FileConfigStore  store(path);
+    PersistentConfig config(store);
+    FanSettings      live = Defaults;
+
+    printf("fresh load: %s\n", config.Load(live) ? "restored" : "defaults");
+
+    // Four hours at 30 FPS.  Every few minutes there's a burst of changes a second or so apart,
+    // like dragging brightness down or stepping through effects.
+
+    srand(1);
+    const int64_t Frame = 33333;
+    uint32_t cChanges = 0;
+    int64_t  nextBurst = 60000000, burstEnd = 0, nextChange = 0;
+
+    for (int64_t now = 0; now < 4LL * 3600 * 1000000; now += Frame)
+    {
+        if (now >= nextBurst)
+        {
+            burstEnd   = now + (2 + rand() % 20) * 1000000LL;
+            nextBurst  = now + (60 + rand() % 600) * 1000000LL;
+            nextChange = now;
+        }
+        if (now < burstEnd && now >= nextChange)
+        {
+            switch (rand() % 3)
+            {
+                case 0: live.Brightness = rand() % 256;           break;
+                case 1: live.Effect     = rand() % 18;            break;
+                case 2: live.PowerLimit = 500 + rand() % 5000;    break;
+            }
+            cChanges++;
+            nextChange = now + (200 + rand() % 1500) * 1000LL;
+        }
+        config.Update(live, now);
+    }
+    config.Flush(4LL * 3600 * 1000000);
+    printf("%u changes over 4 hours cost %u writes\n", cChanges, config.Writes());
+
+    FanSettings restored = Defaults;
+    PersistentConfig reboot(store);
+    bool bLoaded = reboot.Load(restored);
+    printf("after reboot: %s, %s\n", bLoaded ? "restored" : "defaults", memcmp(&restored, &live, sizeof(live)) ? "MISMATCH" : "matches last state");
+
+    // Flip a byte in the stored settings; the checksum should reject it
+
+    FILE * f = fopen(path, "r+b");
+    fseek(f, sizeof(ConfigHeader) + 2, SEEK_SET);
+    fputc(0x5A, f);
+    fclose(f);
+
+    FanSettings damaged = Defaults;
+    PersistentConfig corrupt(store);
+    bLoaded = corrupt.Load(damaged);
+    printf("damaged block: %s, %s\n", bLoaded ? "restored" : "defaults", memcmp(&damaged, &Defaults, sizeof(Defaults)) ? "NOT DEFAULTS" : "defaults kept");
+    return 0;
+}
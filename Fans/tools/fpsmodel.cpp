@@ -0,0 +1,79 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        fpsmodel.cpp
+//
+// Description:
+//
+//   Host tool that predicts the best frame rate for a strip layout, using
+//   the same timing model as the firmware.
+//
+//      g++ -O2 -I../include fpsmodel.cpp -o fpsmodel
+//      ./fpsmodel 3 1000            1000 LEDs split over 3 pins
+//      ./fpsmodel 8 16 16 16 300    Four explicit segments over up to 8 pins
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timingmodel.h"
+
+static int Usage(const char * name)
+{
+    fprintf(stderr, "usage: %s <channels> <total LEDs> | <channels> <segment> <segment> ...\n", name);
+    fprintf(stderr, "       channels and LED counts must be at least 1\n");
+    return 1;
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 3)
+        return Usage(argv[0]);
+
+    for (int i = 1; i < argc; i++)
+        if (atoi(argv[i]) < 1)
+            return Usage(argv[0]);
+
+    size_t cChannels = atoi(argv[1]);
+    const size_t MaxSegments = 64;
+    size_t lengths[MaxSegments];
+    size_t cSegments = 0;
+
+    size_t cWanted = argc == 3 ? cChannels : (size_t)(argc - 2);
+    if (cWanted > MaxSegments)
+    {
+        fprintf(stderr, "%s: %zu segments, at most %zu are supported\n", argv[0], cWanted, MaxSegments);
+        return 1;
+    }
+
+    if (argc == 3)
+    {
+        // One total: split it evenly across the channels, same as ParallelOutput does
+
+        size_t cLeds    = atoi(argv[2]);
+        size_t cSegment = (cLeds + cChannels - 1) / cChannels;
+        for (size_t i = 0; i < cChannels; i++)
+        {
+            lengths[cSegments++] = cLeds < cSegment ? cLeds : cSegment;
+            cLeds -= lengths[cSegments - 1];
+        }
+    }
+    else
+    {
+        for (int i = 2; i < argc; i++)
+            lengths[cSegments++] = atoi(argv[i]);
+    }
+
+    size_t cLeds = 0;
+    for (size_t i = 0; i < cSegments; i++)
+        cLeds += lengths[i];
+
+    printf("%zu LEDs in %zu segments on %zu channels\n", cLeds, cSegments, cChannels);
+    printf("  serial:   %8.0f uS/frame  %6.1f FPS max\n", PredictFrameMicros(lengths, cSegments, 1), PredictMaxFPS(lengths, cSegments, 1));
+    printf("  parallel: %8.0f uS/frame  %6.1f FPS max\n", PredictFrameMicros(lengths, cSegments, cChannels), PredictMaxFPS(lengths, cSegments, cChannels));
+    return 0;
+}
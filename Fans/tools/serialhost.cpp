@@ -0,0 +1,102 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        serialhost.cpp
+//
+// Description:
+//
+//   Runs the firmware's SerialFrameReceiver on the host.  With no arguments it
+//   opens a pseudo-terminal and prints its name, so serialsend can be pointed
+//   at it for a loopback test without any hardware:
+//
+//      g++ -O2 -I../include serialhost.cpp -o serialhost
+//      ./serialhost &                   Prints e.g. "listening on /dev/pts/5"
+//      ./serialsend /dev/pts/5 -e 30 -c 50
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "serialreceiver.h"
+
+static int64_t HostMicros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char * argv[])
+{
+    size_t cLeds   = argc > 2 ? atoi(argv[2]) : 48;
+    int    seconds = argc > 3 ? atoi(argv[3]) : 15;
+    int    fd;
+
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        fd = open(argv[1], O_RDONLY | O_NOCTTY);
+    }
+    else
+    {
+        fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd >= 0 && (grantpt(fd) || unlockpt(fd)))
+            fd = -1;
+    }
+    if (fd < 0)
+    {
+        perror("open");
+        return 1;
+    }
+
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    if (argc <= 1 || argv[1][0] == '-')
+    {
+        printf("listening on %s\n", ptsname(fd));
+        fflush(stdout);
+    }
+
+    // Read as the receive task would, and present at 60 FPS as the render loop would
+
+    SerialFrameReceiver receiver(cLeds);
+    uint8_t * pLeds = new uint8_t[cLeds * 3];
+    uint8_t   buffer[512];
+    int64_t   start = HostMicros(), nextFrame = start;
+
+    while (HostMicros() - start < (int64_t) seconds * 1000000)
+    {
+        pollfd pfd = { fd, POLLIN, 0 };
+        int wait = (int)((nextFrame - HostMicros()) / 1000);
+        if (poll(&pfd, 1, wait > 0 ? wait : 0) > 0 && (pfd.revents & POLLIN))
+        {
+            ssize_t cb = read(fd, buffer, sizeof(buffer));
+            if (cb > 0)
+                receiver.Feed(buffer, cb, HostMicros());
+        }
+
+        int64_t now = HostMicros();
+        if (now >= nextFrame)
+        {
+            receiver.Present(pLeds);
+            nextFrame += 1000000 / 60;
+        }
+    }
+
+    printf("received %u, presented %u, overwritten %u, crc errors %u, bad headers %u, waiting for key %u\n",
+           receiver.ReceivedFrames(), receiver.PresentedFrames(), receiver.OverwrittenFrames(),
+           receiver.CrcErrors(), receiver.BadHeaders(), receiver.WaitingForKey());
+    return 0;
+}
@@ -0,0 +1,171 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        serialsend.cpp
+//
+// Description:
+//
+//   Linux tool that streams test frames to the fans over the USB serial port
+//   using the same framing and codec as the firmware's SerialFrameReceiver.
+//
+//      g++ -O2 -I../include serialsend.cpp -o serialsend
+//      ./serialsend /dev/ttyUSB0                    Raw frames, 48 LEDs, 60 FPS, 2Mbaud
+//      ./serialsend /dev/ttyUSB0 -e 30 -f 0         Encoded, keyframe every 30, flat out
+//      ./serialsend /dev/pts/5 -c 50                Corrupt every 50th frame to test resync
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "serialreceiver.h"
+
+static int64_t HostMicros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static speed_t BaudConstant(long baud)
+{
+    switch (baud)
+    {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 3000000: return B3000000;
+        case 4000000: return B4000000;
+    }
+    return 0;
+}
+
+// A rainbow bar sweeping back and forth over black, so encoded frames have something to skip
+
+static void RenderFrame(uint8_t * p, size_t cLeds, uint32_t frame)
+{
+    memset(p, 0, cLeds * 3);
+    size_t width  = cLeds / 4 + 1;
+    size_t travel = cLeds - width + 1;
+    size_t start  = (frame / travel) & 1 ? travel - 1 - frame % travel : frame % travel;
+    for (size_t i = 0; i < width; i++)
+    {
+        uint8_t hue = (uint8_t)(i * 256 / width + frame);
+        uint8_t * px = p + (start + i) * 3;
+        px[0] = hue < 128 ? 255 - hue * 2 : 0;
+        px[1] = hue < 128 ? hue * 2 : 255 - (hue - 128) * 2;
+        px[2] = hue < 128 ? 0 : (hue - 128) * 2;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <tty> [-b baud] [-l leds] [-f fps] [-s seconds] [-e keyInterval] [-c corruptEvery]\n", argv[0]);
+        return 1;
+    }
+
+    long   baud = SerialFrameReceiver::DefaultBaud;
+    size_t cLeds = 48;
+    int    fps = 60, seconds = 10, keyInterval = 0, corruptEvery = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        int value = atoi(argv[i + 1]);
+        if      (!strcmp(argv[i], "-b")) baud = value;
+        else if (!strcmp(argv[i], "-l")) cLeds = value;
+        else if (!strcmp(argv[i], "-f")) fps = value;
+        else if (!strcmp(argv[i], "-s")) seconds = value;
+        else if (!strcmp(argv[i], "-e")) keyInterval = value;
+        else if (!strcmp(argv[i], "-c")) corruptEvery = value;
+    }
+
+    int fd = open(argv[1], O_WRONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    // Raw 8N1 at the requested rate; pseudo-terminals accept and ignore the speed
+
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        speed_t speed = BaudConstant(baud);
+        if (!speed)
+        {
+            fprintf(stderr, "unsupported baud rate %ld\n", baud);
+            return 1;
+        }
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    size_t       cBytes   = cLeds * 3;
+    uint8_t    * pFrame   = new uint8_t[cBytes];
+    uint8_t    * pEncoded = new uint8_t[MaxEncodedSize(cBytes)];
+    uint8_t    * pPacket  = new uint8_t[MaxEncodedSize(cBytes) + 7];
+    FrameEncoder encoder(cBytes, keyInterval ? keyInterval : 60);
+
+    int64_t  start = HostMicros(), wireBytes = 0;
+    uint32_t frame = 0;
+
+    while (HostMicros() - start < (int64_t) seconds * 1000000)
+    {
+        RenderFrame(pFrame, cLeds, frame);
+
+        size_t cb;
+        if (keyInterval)
+            cb = BuildSerialFrame(SerialEncoded, pEncoded, encoder.Encode(pFrame, pEncoded), pPacket);
+        else
+            cb = BuildSerialFrame(SerialRaw, pFrame, cBytes, pPacket);
+
+        if (corruptEvery && frame % corruptEvery == (uint32_t) corruptEvery - 1)
+            pPacket[cb / 2] ^= 0x10;
+
+        for (size_t sent = 0; sent < cb; )
+        {
+            ssize_t n = write(fd, pPacket + sent, cb - sent);
+            if (n <= 0)
+            {
+                perror("write");
+                return 1;
+            }
+            sent += n;
+        }
+        wireBytes += cb;
+        frame++;
+
+        if (fps)
+        {
+            int64_t due = start + (int64_t) frame * 1000000 / fps;
+            int64_t now = HostMicros();
+            if (due > now)
+                usleep(due - now);
+        }
+    }
+    tcdrain(fd);
+
+    double elapsed = (HostMicros() - start) / 1000000.0;
+    printf("sent %u frames in %.1fs: %.1f FPS, %.0f bytes/frame, %.1f%% of %ld baud\n",
+           frame, elapsed, frame / elapsed, (double) wireBytes / frame, wireBytes * 10 * 100.0 / elapsed / baud, baud);
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,67 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        streamhost.cpp
+//
+// Description:
+//
+//   Runs the firmware's FrameReceiver on a Linux host so the streaming path
+//   can be exercised against streamsend.py over localhost.
+//
+//      g++ -O2 -pthread -I../include streamhost.cpp -o streamhost
+//      ./streamhost 48 10 &
+//      python3 streamsend.py --leds 48 --seconds 8 --jitter 5 --duplicate 0.02
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+#include "framereceiver.h"
+
+int main(int argc, char * argv[])
+{
+    size_t cLeds    = argc > 1 ? atoi(argv[1]) : 48;
+    int    cSeconds = argc > 2 ? atoi(argv[2]) : 10;
+    int    port     = argc > 3 ? atoi(argv[3]) : FrameReceiver::DefaultPort;
+
+    FrameReceiver receiver(cLeds);
+    if (!receiver.Open(port))
+    {
+        perror("bind");
+        return 1;
+    }
+
+    std::atomic<bool> bDone(false);
+    std::thread rx([&] { while (!bDone) receiver.Poll(); });
+
+    // Present at 60 FPS, like the render loop would
+
+    uint8_t * pLeds = new uint8_t[cLeds * 3];
+    int64_t   end   = esp_timer_get_time() + cSeconds * 1000000LL;
+    uint32_t  lastChecksum = 0;
+
+    while (esp_timer_get_time() < end)
+    {
+        if (receiver.Present(esp_timer_get_time(), pLeds))
+        {
+            lastChecksum = 0;
+            for (size_t i = 0; i < cLeds * 3; i++)
+                lastChecksum = lastChecksum * 31 + pLeds[i];
+        }
+        usleep(16667);
+    }
+
+    bDone = true;
+    rx.join();
+
+    printf("presented %u  late %u  dropped %u  duplicate %u  (last frame checksum %08x)\n",
+           receiver.PresentedFrames(), receiver.LateFrames(), receiver.DroppedFrames(), receiver.DuplicateFrames(), lastChecksum);
+    delete [] pLeds;
+    return 0;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+#
+# streamsend.py - Streams a test pattern to a FrameReceiver (on the board or
+# tools/streamhost on this machine) using the NDF1 datagram format from
+# include/framereceiver.h.  Can inject jitter, duplicates, drops and
+# reordering to exercise the jitter buffer.
+#
+# History:     Oct-19-2026     davepl      Created
+
+import argparse
+import colorsys
+import random
+import socket
+import struct
+import time
+
+MAGIC = 0x3146444E
+HEADER = struct.Struct('<IIQHH')        # Magic, Sequence, PresentationMicros, FirstLED, LEDCount
+
+
+def frame_pixels(leds, sequence):
+    hue = (sequence * 4) % 256
+    out = bytearray()
+    for i in range(leds):
+        r, g, b = colorsys.hsv_to_rgb(((hue + i * 8) % 256) / 256.0, 1.0, 1.0)
+        out += bytes((int(r * 255), int(g * 255), int(b * 255)))
+    return out
+
+
+def datagrams(leds, sequence, pts, per_packet):
+    pixels = frame_pixels(leds, sequence)
+    for first in range(0, leds, per_packet):
+        count = min(per_packet, leds - first)
+        yield HEADER.pack(MAGIC, sequence, pts, first, count) + pixels[first * 3:(first + count) * 3]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=49152)
+    parser.add_argument('--leds', type=int, default=48)
+    parser.add_argument('--fps', type=float, default=60)
+    parser.add_argument('--seconds', type=float, default=10)
+    parser.add_argument('--per-packet', type=int, default=480, help='LEDs per datagram')
+    parser.add_argument('--jitter', type=float, default=0, help='max random send delay, ms')
+    parser.add_argument('--duplicate', type=float, default=0, help='chance each frame is sent twice')
+    parser.add_argument('--drop', type=float, default=0, help='chance each frame is not sent')
+    parser.add_argument('--reorder', type=float, default=0, help='chance a frame is held back behind the next one')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    start = time.monotonic()
+    held = None
+    sent = dropped = duplicated = 0
+
+    sequence = 0
+    while time.monotonic() - start < args.seconds:
+        due = start + sequence / args.fps
+        time.sleep(max(0.0, due - time.monotonic()) + random.uniform(0, args.jitter) / 1000.0)
+
+        pts = int(due * 1000000)
+        packets = list(datagrams(args.leds, sequence, pts, args.per_packet))
+
+        if random.random() < args.drop:
+            dropped += 1
+        elif held is None and random.random() < args.reorder:
+            held = packets
+        else:
+            copies = 2 if random.random() < args.duplicate else 1
+            duplicated += copies - 1
+            for _ in range(copies):
+                for packet in packets:
+                    sock.sendto(packet, (args.host, args.port))
+            sent += 1
+            if held:
+                for packet in held:
+                    sock.sendto(packet, (args.host, args.port))
+                held = None
+                sent += 1
+        sequence += 1
+
+    print(f'sent {sent} frames, dropped {dropped}, duplicated {duplicated}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,360 @@
+//+--------------------------------------------------------------------------
+//
+// NightDriver - (c) 2020 Dave Plummer.  All Rights Reserved.
+//
+// File:        analogrgb.h
+//
+// Description:
+//
+//   Drives an analog (non-addressable) RGB LED or strip from three LEDC PWM
+//   channels at 12 to 16 bits, with gamma correction, from a 16-bit hue.
+//   Fades between colors can be handed to the LEDC fade hardware.
+//
+// History:     Oct-19-2026     davepl      Created
+//
+//---------------------------------------------------------------------------
+
+#pragma once
+
+#include <Arduino.h>
+#include <math.h>
+#include <driver/ledc.h>
+#include <esp_idf_version.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// AnalogColor
+//
+// Linear intensity per channel, 0-65535
+
+struct AnalogColor
+{
+    uint16_t r, g, b;
+};
+
+// HueToAnalog
+//
+// Same six-segment color wheel as the old hueToRGB, but with 16 bits of hue and brightness and
+// no divisions.  It only touches its arguments, so it's safe to call from anywhere for any number
+// of channels at once.
+
+inline AnalogColor HueToAnalog(uint16_t hue, uint16_t brightness = 65535)
+{
+    uint32_t scaledHue = (uint32_t) hue * 6;                // Segment in the top bits, offset in the low 16
+    uint8_t  segment   = scaledHue >> 16;
+    uint32_t offset    = scaledHue & 0xFFFF;
+
+    uint16_t prev = ((uint32_t) brightness * (65535 - offset)) >> 16;
+    uint16_t next = ((uint32_t) brightness * offset) >> 16;
+
+    switch (segment)
+    {
+        case 0:  return AnalogColor { brightness, next, 0 };           // red
+        case 1:  return AnalogColor { prev, brightness, 0 };           // yellow
+        case 2:  return AnalogColor { 0, brightness, next };           // green
+        case 3:  return AnalogColor { 0, prev, brightness };           // cyan
+        case 4:  return AnalogColor { next, 0, brightness };           // blue
+        default: return AnalogColor { brightness, 0, prev };           // magenta
+    }
+}
+
+// AnalogGamma
+//
+// Perceived brightness isn't linear in duty cycle, so a linear fade spends most of its time
+// looking nearly full on.  The curve is kept as 257 points and interpolated, which at 16 bits out
+// leaves the bottom of the range with steps well under 1% of full scale.
+
+class AnalogGamma
+{
+  private:
+
+    uint16_t _lut[257];
+
+  public:
+
+    AnalogGamma(float gamma = 2.2f)
+    {
+        for (int i = 0; i <= 256; i++)
+            _lut[i] = (uint16_t)(powf(i / 256.0f, gamma) * 65535.0f + 0.5f);
+    }
+
+    uint16_t Apply(uint16_t linear) const
+    {
+        uint16_t a = _lut[linear >> 8];
+        uint16_t b = _lut[(linear >> 8) + 1];
+        return a + (((uint32_t)(b - a) * (linear & 0xFF)) >> 8);
+    }
+};
+
+// AnalogRGB
+//
+// One RGB output on three LEDC channels.  LEDC counts at 80MHz, so the resolution limits the PWM
+// frequency: 12 bits goes up to about 19kHz, 14 bits to 4.8kHz, 16 bits to 1.2kHz.  12 bits at the
+// old 12kHz keeps the strip quiet and flicker-free and already gives 4096 steps.
+//
+// StartFade() has the LEDC hardware ramp each channel's duty to a new color on its own, and its
+// fade-end interrupt tells us when the last channel gets there.  The ramp is linear in duty, so
+// gamma is only exact at the ends; a path broken into a few dozen segments looks smooth.  Don't
+// Write() while a fade is running.
+
+class AnalogRGB
+{
+  public:
+
+    static const uint32_t DefaultFrequency  = 12000;
+    static const uint8_t  DefaultResolution = 12;
+
+  private:
+
+    uint8_t             _pins[3];
+    uint8_t             _channels[3];
+    uint8_t             _resolution;
+    uint32_t            _dutyScale;             // Full scale duty plus one, for mapping 16 bits onto it
+    const AnalogGamma & _gamma;
+    uint32_t            _duty[3];               // What each channel is at, or fading to
+    SemaphoreHandle_t   _hFadeDone;
+    volatile uint32_t   _cFading;               // Channels whose hardware fade hasn't finished
+
+    // Arduino numbers LEDC channels 0-15: the first eight are the high speed group, the rest low speed
+
+    ledc_mode_t Mode(int i) const
+    {
+        return _channels[i] < 8 ? LEDC_HIGH_SPEED_MODE : LEDC_LOW_SPEED_MODE;
+    }
+
+    ledc_channel_t Channel(int i) const
+    {
+        return (ledc_channel_t)(_channels[i] % 8);
+    }
+
+    // Runs in the LEDC interrupt once per channel as its fade ends
+
+    static bool IRAM_ATTR FadeEnded(const ledc_cb_param_t * param, void * pv)
+    {
+        AnalogRGB * pThis = (AnalogRGB *) pv;
+        BaseType_t  bWoken = pdFALSE;
+        if (param->event == LEDC_FADE_END_EVT && __atomic_sub_fetch(&pThis->_cFading, 1, __ATOMIC_ACQ_REL) == 0)
+            xSemaphoreGiveFromISR(pThis->_hFadeDone, &bWoken);
+        return bWoken == pdTRUE;
+    }
+
+  public:
+
+    AnalogRGB(uint8_t redPin, uint8_t greenPin, uint8_t bluePin, uint8_t firstChannel, const AnalogGamma & gamma)
+        : _pins { redPin, greenPin, bluePin },
+          _channels { firstChannel, (uint8_t)(firstChannel + 1), (uint8_t)(firstChannel + 2) },
+          _resolution(DefaultResolution),
+          _dutyScale((1 << DefaultResolution) + 1),
+          _gamma(gamma),
+          _duty { 0, 0, 0 },
+          _hFadeDone(nullptr),
+          _cFading(0)
+    {
+    }
+
+    // Begin
+    //
+    // Sets up the three channels.  Returns false if LEDC can't run at that frequency with that
+    // many bits.
+
+    bool Begin(uint32_t frequency = DefaultFrequency, uint8_t resolution = DefaultResolution)
+    {
+        if (resolution < 1 || resolution > 16 || (80000000UL >> resolution) < frequency)
+            return false;
+
+        _resolution = resolution;
+        _dutyScale  = (1UL << resolution) + 1;
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (!ledcSetup(_channels[i], frequency, resolution))
+                return false;
+            ledcAttachPin(_pins[i], _channels[i]);
+            ledcWrite(_channels[i], 0);
+            _duty[i] = 0;
+        }
+        return true;
+    }
+
+    // BeginFades
+    //
+    // Installs the LEDC fade service and our fade-end callbacks.  Call after Begin().  Without a
+    // fade-end event (ESP-IDF before 4.4) fades still run, and WaitForFade() just times out.
+
+    bool BeginFades()
+    {
+        if (!_hFadeDone)
+            _hFadeDone = xSemaphoreCreateBinary();
+
+        esp_err_t err = ledc_fade_func_install(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)        // Already installed is fine
+            return false;
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+        ledc_cbs_t callbacks = { FadeEnded };
+        for (int i = 0; i < 3; i++)
+            if (ledc_cb_register(Mode(i), Channel(i), &callbacks, this) != ESP_OK)
+                return false;
+#endif
+        return true;
+    }
+
+    // StartFade
+    //
+    // Starts the hardware fading to a color over the given time and returns at once.  Returns the
+    // number of channels that are actually changing; when that's zero there's nothing to wait for.
+
+    int StartFade(const AnalogColor & color, uint32_t millis)
+    {
+        uint32_t target[3] = { Duty(color.r), Duty(color.g), Duty(color.b) };
+
+        int cChanging = 0;
+        for (int i = 0; i < 3; i++)
+            cChanging += target[i] != _duty[i];
+
+        xSemaphoreTake(_hFadeDone, 0);                          // Drop any leftover signal
+        __atomic_store_n(&_cFading, cChanging, __ATOMIC_RELEASE);
+
+        for (int i = 0; i < 3; i++)
+        {
+            if (target[i] == _duty[i])
+                continue;
+            ledc_set_fade_with_time(Mode(i), Channel(i), target[i], millis);
+            ledc_fade_start(Mode(i), Channel(i), LEDC_FADE_NO_WAIT);
+            _duty[i] = target[i];
+        }
+        return cChanging;
+    }
+
+    // WaitForFade
+    //
+    // Blocks until the fade started last has finished on every channel, or the timeout passes
+
+    bool WaitForFade(uint32_t timeoutMillis)
+    {
+        return xSemaphoreTake(_hFadeDone, pdMS_TO_TICKS(timeoutMillis)) == pdTRUE;
+    }
+
+    // Duty
+    //
+    // Gamma corrects a linear 16-bit level and scales it to the LEDC duty, 0 to fully on
+
+    uint32_t Duty(uint16_t linear) const
+    {
+        return ((uint32_t) _gamma.Apply(linear) * _dutyScale) >> 16;
+    }
+
+    void Write(const AnalogColor & color)
+    {
+        _duty[0] = Duty(color.r);
+        _duty[1] = Duty(color.g);
+        _duty[2] = Duty(color.b);
+        for (int i = 0; i < 3; i++)
+            ledcWrite(_channels[i], _duty[i]);
+    }
+
+    uint8_t Resolution() const
+    {
+        return _resolution;
+    }
+};
+
+// AnalogKeyframe
+//
+// One segment of a fade sequence: fade to Color over Millis
+
+struct AnalogKeyframe
+{
+    AnalogColor Color;
+    uint32_t    Millis;
+};
+
+// AnalogFadeSequence
+//
+// Plays a list of keyframes through the fade hardware from a small task of its own.  The task
+// programs a segment and then sleeps until the fade-end interrupt wakes it for the next one, so
+// between keyframes nothing runs at all and loop() is free for other work.
+
+class AnalogFadeSequence
+{
+  private:
+
+    AnalogRGB            & _strip;
+    const AnalogKeyframe * _pKeyframes;
+    size_t                 _cKeyframes;
+    bool                   _bLoop;
+    volatile bool          _bPlaying;
+    volatile bool          _bStop;
+    volatile uint32_t      _cSegments;
+
+    static void TaskEntry(void * pv)
+    {
+        ((AnalogFadeSequence *) pv)->Run();
+        vTaskDelete(nullptr);
+    }
+
+    void Run()
+    {
+        do
+        {
+            for (size_t i = 0; i < _cKeyframes && !_bStop; i++)
+            {
+                const AnalogKeyframe & key = _pKeyframes[i];
+                if (_strip.StartFade(key.Color, key.Millis))
+                    _strip.WaitForFade(key.Millis + 100);       // Margin for the last PWM cycle and ISR latency
+                else
+                    vTaskDelay(pdMS_TO_TICKS(key.Millis));      // Nothing changes, so just hold
+                _cSegments++;
+            }
+        } while (_bLoop && !_bStop);
+
+        _bPlaying = false;
+    }
+
+  public:
+
+    AnalogFadeSequence(AnalogRGB & strip)
+        : _strip(strip),
+          _pKeyframes(nullptr),
+          _cKeyframes(0),
+          _bLoop(false),
+          _bPlaying(false),
+          _bStop(false),
+          _cSegments(0)
+    {
+    }
+
+    // Play
+    //
+    // Keyframes are used in place, so they have to outlive the sequence.  Returns false if a
+    // sequence is already playing or the task can't be started.
+
+    bool Play(const AnalogKeyframe * pKeyframes, size_t cKeyframes, bool bLoop = false, int core = 0)
+    {
+        if (_bPlaying)
+            return false;
+
+        _pKeyframes = pKeyframes;
+        _cKeyframes = cKeyframes;
+        _bLoop      = bLoop;
+        _bStop      = false;
+        _bPlaying   = true;
+
+        if (xTaskCreatePinnedToCore(TaskEntry, "Analog Fades", 2048, this, 1, nullptr, core) != pdPASS)
+            _bPlaying = false;
+        return _bPlaying;
+    }
+
+    // Stop
+    //
+    // Ends the sequence once the current segment has finished
+
+    void Stop()
+    {
+        _bStop = true;
+    }
+
+    bool     IsPlaying() const  { return _bPlaying; }
+    uint32_t Segments() const   { return _cSegments; }
+};
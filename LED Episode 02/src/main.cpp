@@ -1,89 +1,41 @@
 #include <Arduino.h>
 
+#include "analogrgb.h"
+
 #define RED_PIN   16
 #define GREEN_PIN 17
 #define BLUE_PIN  18
 
-// Courtesy http://www.instructables.com/id/How-to-Use-an-RGB-LED/?ALLSTEPS
-// function to convert a color to its Red, Green, and Blue components.
+#define CYCLE_MS  25600     // One trip around the color wheel, same pace as stepping 8-bit hue every 100ms
+#define KEYFRAMES 48        // Segments the hardware fades through per trip, eight per side of the wheel
 
-uint32_t R, G, B;           // the Red Green and Blue color components
+AnalogGamma        g_Gamma;                                                // Shared by every analog output
+AnalogRGB          g_Strip(RED_PIN, GREEN_PIN, BLUE_PIN, 1, g_Gamma);      // PWM generators 1-3 for red, green and blue
+AnalogFadeSequence g_Fades(g_Strip);
+AnalogKeyframe     g_Wheel[KEYFRAMES];
 
-void hueToRGB(uint8_t hue, uint8_t brightness)
+void setup()
 {
-    uint16_t scaledHue = (hue * 6);
-    uint8_t segment = scaledHue / 256; // segment 0 to 5 around the
-                                            // color wheel
-    uint16_t segmentOffset =
-      scaledHue - (segment * 256); // position within the segment
-
-    uint8_t complement = 0;
-    uint16_t prev = (brightness * ( 255 -  segmentOffset)) / 256;
-    uint16_t next = (brightness *  segmentOffset) / 256;
+  Serial.begin(115200);
 
-    switch(segment ) {
-    case 0:      // red
-        R = brightness;
-        G = next;
-        B = complement;
-    break;
-    case 1:     // yellow
-        R = prev;
-        G = brightness;
-        B = complement;
-    break;
-    case 2:     // green
-        R = complement;
-        G = brightness;
-        B = next;
-    break;
-    case 3:    // cyan
-        R = complement;
-        G = prev;
-        B = brightness;
-    break;
-    case 4:    // blue
-        R = next;
-        G = complement;
-        B = brightness;
-    break;
-   case 5:      // magenta
-    default:
-        R = brightness;
-        G = complement;
-        B = prev;
-    break;
-    }
-}
-
-void setup() 
-{
   pinMode(RED_PIN,   OUTPUT);
   pinMode(GREEN_PIN, OUTPUT);
   pinMode(BLUE_PIN,  OUTPUT);
 
-  digitalWrite(GREEN_PIN, HIGH);
-  digitalWrite(BLUE_PIN,  HIGH);  
+  g_Strip.Begin(12000, 12);         // Set it to 12kHZ and 12-bit resolution
+  g_Strip.Write(HueToAnalog(0));    // Start on red at max brightness
 
-  ledcAttachPin(RED_PIN, 1);        // Assign PWM generator 1 to RED
-  ledcAttachPin(GREEN_PIN, 2);      // Assign PWM generator 2 to GREEN
-  ledcAttachPin(BLUE_PIN, 3);       // Assign PWM generator 3 to BLUE
+  // The LEDC fade hardware does the color wheel on its own; the CPU only wakes up to start each
+  // of the segments
 
-  ledcSetup(1, 12000, 8);           // Set it to 12kHZ and 8-bit resolution
-  ledcSetup(2, 12000, 8);           // Set it to 12kHZ and 8-bit resolution
-  ledcSetup(3, 12000, 8);           // Set it to 12kHZ and 8-bit resolution
+  for (int i = 0; i < KEYFRAMES; i++)
+    g_Wheel[i] = AnalogKeyframe { HueToAnalog((i + 1) * 65536 / KEYFRAMES), CYCLE_MS / KEYFRAMES };
+
+  if (!g_Strip.BeginFades() || !g_Fades.Play(g_Wheel, KEYFRAMES, true))
+    Serial.println("No hardware fades");
 }
 
-void loop() 
+void loop()
 {
-  for (int c = 0; c < 256; c++)
-  {
-    hueToRGB(c, 255);             // Convert color to max brightness
-
-    ledcWrite(1, R);
-    ledcWrite(2, G);
-    ledcWrite(3, B);
-
-    delay(100);
-  }
-}
\ No newline at end of file
+  delay(1000);                      // Nothing to do; the fades run without us
+}
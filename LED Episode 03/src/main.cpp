@@ -1,11 +1,12 @@
 #include <Arduino.h>
 #include <U8g2lib.h>
 
-U8G2_SSD1306_128X64_NONAME_F_SW_I2C g_TFT(U8G2_R2, 15, 4, 16);
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C g_TFT(U8G2_R2, 16, 15, 4);     // Reset, clock, data on the I2C peripheral
 
 void setup()
 {
     pinMode(LED_BUILTIN, OUTPUT);           // Set the LED pin to output
+    g_TFT.setBusClock(400000);              // 400kHz I2C
     g_TFT.begin();                          // One-time startup
     g_TFT.clear();                          // Clear the screen
     g_TFT.setFont(u8g2_font_profont15_tf);  // Choose a suitable font
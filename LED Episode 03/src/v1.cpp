@@ -5,10 +5,11 @@
 #define DISPLAY_DATA_PIN    4
 #define DISPLAY_RESET_PIN   16
 
-U8G2_SSD1306_128X64_NONAME_F_SW_I2C g_OLED(U8G2_R2, DISPLAY_CLOCK_PIN, DISPLAY_DATA_PIN, DISPLAY_RESET_PIN);
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C g_OLED(U8G2_R2, DISPLAY_RESET_PIN, DISPLAY_CLOCK_PIN, DISPLAY_DATA_PIN);
 
 void setup() 
 {
+  g_OLED.setBusClock(400000);
   g_OLED.begin();
   g_OLED.clear();
   g_OLED.setFont(u8g2_font_profont15_tf);  // Choose a suitable font
@@ -22,6 +22,7 @@
 #define OLED_CLOCK  15          // Pins for the OLED display
 #define OLED_DATA   4
 #define OLED_RESET  16
+#define OLED_I2C_HZ 400000      // Hardware I2C clock for the OLED; the SSD1306 is specified to 400kHz
 
 #define NUM_LEDS    40          // FastLED definitions
 #define LED_PIN     5
@@ -48,6 +49,7 @@ void setup()
   while (!Serial) { }
   Serial.println("ESP32 Startup");
 
+  g_OLED.setBusClock(OLED_I2C_HZ);
   g_OLED.begin();
   g_OLED.clear();
   g_OLED.setFont(u8g2_font_profont15_tf);